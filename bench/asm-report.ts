@@ -0,0 +1,201 @@
+// codegen report
+// the primary toolchain also emits -S plus the compiler's loop remarks
+// (gcc -fopt-info, clang -Rpass) for baseline and candidate, so a speedup can
+// be traced to vectorization or unrolling rather than taken on faith
+
+import { mkdtemp, readFile, rm, writeFile } from "fs/promises";
+import { tmpdir } from "os";
+import { join } from "path";
+import { runCommand } from "./command";
+import { buildKey } from "./compile-farm";
+import { getTimedScheduler } from "./scheduler";
+import { SCHEDULER_CONFIG } from "./constants";
+import { sourceFileName, type Toolchain } from "./toolchain";
+
+export type CodegenConfig = {
+  enabled: boolean;
+  maxAsmLines: number; // of the kernel's assembly kept in the result
+  maxFunctions: number; // largest functions listed, besides the kernel and main
+};
+
+export type FunctionCodegen = {
+  name: string;
+  instructions: number; // static count
+  vectorInstructions: number; // packed simd, scalar sse/avx ops excluded
+  vectorWidthBits: number; // widest simd register used, 0 = scalar only
+};
+
+export type LoopRemark = {
+  line: number;
+  kind: "vectorized" | "unrolled" | "missed";
+  detail: string; // e.g. "using 32 byte vectors", "4 iterations completely unrolled"
+};
+
+export type CodegenReport = {
+  functions: FunctionCodegen[];
+  loops: LoopRemark[];
+  maxVectorWidthBits: number;
+  kernel?: string; // function the asm below belongs to (the harness kernel, else main)
+  kernelInstructions?: number;
+  kernelAsm?: string;
+};
+
+const isClang = (compiler: string) => /clang/.test(compiler);
+
+function remarkFlags(compiler: string): string[] {
+  return isClang(compiler)
+    ? ["-Rpass=loop-vectorize", "-Rpass-missed=loop-vectorize", "-Rpass=loop-unroll"]
+    : ["-fopt-info-vec-optimized", "-fopt-info-vec-missed", "-fopt-info-loop-optimized"];
+}
+
+// gcc:   main.c:12:5: optimized: loop vectorized using 32 byte vectors
+//        main.c:12:5: missed: couldn't vectorize loop
+// clang: main.c:12:5: remark: vectorized loop (vectorization width: 8, interleaved count: 4) [-Rpass=loop-vectorize]
+export function parseLoopRemarks(stderr: string): LoopRemark[] {
+  const loops: LoopRemark[] = [];
+  const seen = new Set<string>();
+  const lines = stderr.split("\n");
+
+  lines.forEach((text, i) => {
+    const m = text.match(/^main\.c(?:pp)?:(\d+):\d+: (optimized|missed|remark): (.*?)(?: \[-R[^\]]*\])?$/);
+    if (!m) return;
+    const line = Number(m[1]);
+    const message = m[3];
+    let remark: LoopRemark | null = null;
+
+    let v: RegExpMatchArray | null;
+    if ((v = message.match(/^loop vectorized (using .*)$/))) remark = { line, kind: "vectorized", detail: v[1] };
+    else if ((v = message.match(/^vectorized loop \((.*)\)$/))) remark = { line, kind: "vectorized", detail: v[1] };
+    else if (/unroll/.test(message) && m[2] !== "missed") remark = { line, kind: "unrolled", detail: message };
+    else if (/^(couldn't vectorize loop|loop not vectorized)/.test(message)) {
+      // gcc gives the reason on the next missed line
+      const reason = lines[i + 1]?.match(/^main\.c(?:pp)?:\d+:\d+: missed: (.*)$/)?.[1];
+      remark = { line, kind: "missed", detail: reason ?? message };
+    }
+    if (!remark) return;
+
+    const key = `${remark.line}:${remark.kind}:${remark.detail}`;
+    if (seen.has(key)) return; // inlined copies repeat their remarks
+    seen.add(key);
+    loops.push(remark);
+  });
+  return loops.sort((a, b) => a.line - b.line);
+}
+
+// register width of one instruction, 0 when it is scalar
+function vectorWidth(mnemonic: string, operands: string): number {
+  if (/%zmm/.test(operands)) return 512;
+  if (/%ymm/.test(operands)) return 256;
+  if (/%xmm/.test(operands)) {
+    const regs = operands.match(/%xmm\d+/g) ?? [];
+    // scalar float ops and moves live in xmm registers too; so does the xor
+    // zeroing idiom
+    if (/^v?(.*s[sd]|cvt.*|movd|movq|u?comis[sd])$/.test(mnemonic)) return 0;
+    if (/xor/.test(mnemonic) && new Set(regs).size === 1) return 0;
+    return 128;
+  }
+  // aarch64 neon: v0.4s is 128 bits, v0.2s is 64
+  const neon = operands.match(/\bv\d+\.(\d+)([bhsd])\b/);
+  if (neon) {
+    const bits = { b: 8, h: 16, s: 32, d: 64 }[neon[2] as "b" | "h" | "s" | "d"];
+    return Number(neon[1]) * bits;
+  }
+  return 0;
+}
+
+// functions from `.type name, @function` to `.size name`
+export function parseAssembly(asm: string): Map<string, { codegen: FunctionCodegen; lines: string[] }> {
+  const functions = new Map<string, { codegen: FunctionCodegen; lines: string[] }>();
+  const isFunction = new Set([...asm.matchAll(/^\s*\.type\s+([\w.$]+),\s*[@%]function/gm)].map((m) => m[1]));
+  let current: { codegen: FunctionCodegen; lines: string[] } | null = null;
+
+  for (const raw of asm.split("\n")) {
+    const label = raw.match(/^([\w.$]+):/);
+    if (label && isFunction.has(label[1])) {
+      current = { codegen: { name: label[1], instructions: 0, vectorInstructions: 0, vectorWidthBits: 0 }, lines: [raw] };
+      functions.set(label[1], current);
+      continue;
+    }
+    if (!current) continue;
+    if (/^\s*\.size\s/.test(raw)) {
+      current = null;
+      continue;
+    }
+
+    const ins = raw.match(/^\s+([a-z][\w.]*)\s*(.*)$/);
+    if (ins && !raw.trim().startsWith(".")) {
+      current.lines.push(raw);
+      current.codegen.instructions++;
+      const width = vectorWidth(ins[1], ins[2]);
+      if (width > 0) {
+        current.codegen.vectorInstructions++;
+        current.codegen.vectorWidthBits = Math.max(current.codegen.vectorWidthBits, width);
+      }
+    } else if (/^\.?L?[\w.$]+:/.test(raw)) {
+      current.lines.push(raw); // local labels keep the loop structure readable
+    }
+  }
+  return functions;
+}
+
+const reports = new Map<string, Promise<CodegenReport | undefined>>();
+
+// one -S compile with remarks; memoized since every candidate shares the
+// baseline's. undefined when the compiler rejects it
+export function codegenReport(
+  tc: Toolchain,
+  code: string,
+  extraFlags: string[],
+  kernel: string | undefined,
+  config: CodegenConfig
+): Promise<CodegenReport | undefined> {
+  const key = `${buildKey(tc, code, extraFlags)}:${kernel ?? ""}`;
+  let report = reports.get(key);
+  if (!report) {
+    report = buildReport(tc, code, extraFlags, kernel, config);
+    reports.set(key, report);
+  }
+  return report;
+}
+
+async function buildReport(
+  tc: Toolchain,
+  code: string,
+  extraFlags: string[],
+  kernel: string | undefined,
+  config: CodegenConfig
+): Promise<CodegenReport | undefined> {
+  const dir = await mkdtemp(join(tmpdir(), "optibench-asm-"));
+  try {
+    const source = join(dir, sourceFileName(tc));
+    const output = join(dir, "main.s");
+    await writeFile(source, code);
+    // -flto would leave gimple instead of assembly in main.s
+    const flags = [...tc.flags, ...extraFlags].filter((f) => !f.startsWith("-flto"));
+    const run = await runCommand(tc.compiler, [...flags, "-S", "-o", output, source, ...remarkFlags(tc.compiler)], {
+      cpus: getTimedScheduler(SCHEDULER_CONFIG).compileCpus,
+    });
+    if (run.exitCode !== 0) return undefined;
+
+    const functions = parseAssembly(await readFile(output, "utf-8"));
+    // c++ kernels are mangled: _Z<length><name><parameters>
+    const kernelSymbol = kernel && [...functions.keys()].find((f) => f === kernel || f.startsWith(`_Z${kernel.length}${kernel}`));
+    const focus = kernelSymbol ?? (functions.has("main") ? "main" : undefined);
+    const listed = [...functions.values()]
+      .map((f) => f.codegen)
+      .sort((a, b) => b.instructions - a.instructions)
+      .filter((f, i) => i < config.maxFunctions || f.name === focus || f.name === "main");
+    const focused = focus ? functions.get(focus)! : undefined;
+
+    return {
+      functions: listed,
+      loops: parseLoopRemarks(run.stderr.replaceAll(`${dir}/`, "")),
+      maxVectorWidthBits: Math.max(0, ...listed.map((f) => f.vectorWidthBits)),
+      kernel: focus,
+      kernelInstructions: focused?.codegen.instructions,
+      kernelAsm: focused?.lines.slice(0, config.maxAsmLines).join("\n"),
+    };
+  } finally {
+    await rm(dir, { recursive: true, force: true });
+  }
+}
@@ -0,0 +1,118 @@
+// persistent baseline cache
+// baselines only depend on the test source, flags, toolchain and host, so we
+// compile and time them once and share the result across models and runs
+
+import { createHash } from "crypto";
+import { writeFile, readFile, mkdir, rename } from "fs/promises";
+import { existsSync } from "fs";
+import { join } from "path";
+import { cpus, arch } from "os";
+import { execFileSync } from "child_process";
+import type { SampleStats } from "./sampling";
+import type { PerfCounters } from "./perf-counters";
+import type { ResourceUsage } from "./sandbox";
+
+export type BaselineEntry = {
+  key: string;
+  testId: string;
+  compiler: string;
+  flags: string[];
+  iterations: number;
+  timingMode: "process" | "harness";
+  timeMs: number;
+  samplesMs: number[];
+  stats: SampleStats;
+  counters?: PerfCounters;
+  resources?: ResourceUsage;
+  bytes?: number; // harness spec's work per call
+  flops?: number;
+  ops?: number;
+  output: string;
+  createdAt: string;
+};
+
+const compilerVersionCache = new Map<string, string>();
+
+// full version banner of a compiler, e.g. "gcc (Debian 12.2.0-14) 12.2.0"
+export function compilerVersion(compiler: string): string {
+  let version = compilerVersionCache.get(compiler);
+  if (version === undefined) {
+    try {
+      version = execFileSync(compiler, ["--version"], { encoding: "utf-8" }).split("\n")[0].trim();
+    } catch {
+      version = "unknown";
+    }
+    compilerVersionCache.set(compiler, version);
+  }
+  return version;
+}
+
+// cpu model + arch, good enough to tell benchmark hosts apart
+export function hostCpu(): string {
+  return `${cpus()[0]?.model ?? "unknown"} (${arch()}, ${cpus().length} cpus)`;
+}
+
+export function baselineCacheKey(parts: {
+  code: string;
+  compiler: string;
+  flags: string[]; // includes a "+pgo" marker for profile-guided builds
+  iterations: number;
+  timing: unknown; // timing mode, harness spec and sampling config
+}): string {
+  return createHash("sha256")
+    .update(
+      JSON.stringify({
+        code: parts.code,
+        compiler: compilerVersion(parts.compiler),
+        flags: parts.flags,
+        iterations: parts.iterations,
+        timing: parts.timing,
+        host: hostCpu(),
+      })
+    )
+    .digest("hex");
+}
+
+// in-flight lookups so concurrent models share one compile + timing run
+const pending = new Map<string, Promise<BaselineEntry | null>>();
+
+export async function getOrCreateBaseline(
+  cacheDir: string,
+  key: string,
+  create: () => Promise<Omit<BaselineEntry, "key" | "createdAt"> | null>
+): Promise<BaselineEntry | null> {
+  const inFlight = pending.get(key);
+  if (inFlight) return inFlight;
+
+  // failures (null or thrown) are not cached so the next caller retries
+  const promise = (async () => {
+    const file = join(cacheDir, "baselines", `${key}.json`);
+    if (existsSync(file)) {
+      try {
+        return JSON.parse(await readFile(file, "utf-8")) as BaselineEntry;
+      } catch {
+        // corrupt entry, rebuild it below
+      }
+    }
+
+    const created = await create();
+    if (!created) {
+      pending.delete(key);
+      return null;
+    }
+
+    const entry: BaselineEntry = { ...created, key, createdAt: new Date().toISOString() };
+    await mkdir(join(cacheDir, "baselines"), { recursive: true });
+    // write then rename so a crash never leaves a half-written entry
+    const tmp = `${file}.${process.pid}.tmp`;
+    await writeFile(tmp, JSON.stringify(entry, null, 2));
+    await rename(tmp, file);
+    return entry;
+  })().catch((err) => {
+    pending.delete(key);
+    throw err;
+  });
+
+  pending.set(key, promise);
+  return promise;
+}
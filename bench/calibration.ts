@@ -0,0 +1,224 @@
+// noise-floor calibration and host fingerprint
+// every run starts by timing a fixed reference kernel on a timing core: timer
+// resolution, run-to-run jitter in-process and per process, and the clock the
+// core actually ran at. speedups inside the resulting noise floor are flagged
+
+import { spawnSync } from "child_process";
+import { arch, cpus, hostname, release } from "os";
+import { runCommand } from "./command";
+import { compilerVersion } from "./baseline-cache";
+import { farmBuild } from "./compile-farm";
+import { median } from "./sampling";
+import { getTimedScheduler, readSys } from "./scheduler";
+import { availableToolchains, forLanguage, type Toolchain } from "./toolchain";
+import { measurePeaks, type HostPeaks } from "./roofline";
+import { ROOFLINE_CONFIG, SANDBOX_CONFIG, SCHEDULER_CONFIG, TOOLCHAINS } from "./constants";
+
+export type CalibrationConfig = {
+  enabled: boolean;
+  iterations: number; // in-process samples of the reference kernel, the first is warmup
+  processRuns: number; // whole-process samples, timed like process-mode tests
+  loops: number; // dependent adds per sample, ~1 cycle each
+  noiseMultiplier: number; // floor = multiplier * relative jitter
+};
+
+export type HostFingerprint = {
+  hostname: string;
+  cpuModel: string;
+  arch: string;
+  logicalCpus: number;
+  microcode?: string;
+  governor?: string; // cpufreq scaling governor of cpu0
+  smt?: boolean;
+  turbo?: boolean; // intel_pstate no_turbo / cpufreq boost
+  maxMHz?: number; // cpuinfo_max_freq
+  kernel: string;
+  compilers: Record<string, string>; // compiler -> version banner
+  nativeFlags: Record<string, string>; // compiler -> what -march=native resolves to
+};
+
+export type Calibration = {
+  timerResolutionNs: number; // smallest step of CLOCK_MONOTONIC_RAW seen between back-to-back reads
+  referenceMs: number; // median in-process time of the reference kernel
+  harnessJitter: number; // MAD / median of the in-process samples
+  processJitter: number; // MAD / median of whole-process runs
+  estimatedGHz: number; // loops / time of the add chain, a rough effective clock
+  frequencyRamp: number; // first sample / median, > 1 when the core was still clocking up
+  noiseFloor: { harness: number; process: number }; // relative speed change that can't be told from noise
+  peaks?: HostPeaks; // single-core compute and bandwidth roofs, see roofline.ts
+};
+
+// x += i behind an empty asm barrier: one dependent add per iteration that the
+// compiler can neither vectorize nor fold
+const REFERENCE_KERNEL = `#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+int main(int argc, char **argv) {
+  int iterations = argc > 1 ? atoi(argv[1]) : 1;
+  long loops = argc > 2 ? atol(argv[2]) : 1000000;
+
+  uint64_t resolution = UINT64_MAX;
+  for (int i = 0; i < 10000; i++) {
+    uint64_t a = now_ns(), b = now_ns();
+    while (b == a) b = now_ns();
+    if (b - a < resolution) resolution = b - a;
+  }
+  printf("resolution %llu\\n", (unsigned long long)resolution);
+
+  for (int it = 0; it < iterations; it++) {
+    uint64_t x = (uint64_t)it;
+    uint64_t t0 = now_ns();
+    for (long i = 0; i < loops; i++) {
+      x += (uint64_t)i;
+      __asm__ volatile("" : "+r"(x));
+    }
+    uint64_t t1 = now_ns();
+    printf("sample %llu %llu\\n", (unsigned long long)(t1 - t0), (unsigned long long)x);
+  }
+  return 0;
+}
+`;
+
+const relativeMad = (values: number[]) => {
+  const med = median(values);
+  return med > 0 ? median(values.map((v) => Math.abs(v - med))) / med : 0;
+};
+
+// the c toolchains plus their c++ drivers, installed ones only
+function hostCompilers(): Toolchain[] {
+  const all = availableToolchains([...TOOLCHAINS, ...TOOLCHAINS.map((tc) => forLanguage(tc, "cpp"))]);
+  return all.filter((tc, i) => all.findIndex((other) => other.compiler === tc.compiler) === i);
+}
+
+// gcc: the -march / -m flags cc1 gets; clang: -target-cpu and +features.
+// -### prints the driver's commands to stderr without running them
+function resolveNative(compiler: string): string | undefined {
+  const run = spawnSync(compiler, ["-march=native", "-###", "-E", "-x", "c", "/dev/null"], { encoding: "utf-8" });
+  return run.status === 0 ? parseNative(run.stderr) : undefined;
+}
+
+function parseNative(out: string): string | undefined {
+  const clangCpu = out.match(/"-target-cpu" "([^"]+)"/);
+  if (clangCpu) {
+    const features = [...out.matchAll(/"-target-feature" "\+([^"]+)"/g)].map((m) => m[1]);
+    return [clangCpu[1], ...features].join(" ");
+  }
+  const cc1 = out.split("\n").find((l) => /cc1(plus)?\s/.test(l) && /-march=/.test(l));
+  if (!cc1) return undefined;
+  const flags = cc1.match(/"?-m(arch|tune)=[^\s"]+"?|\s-m(?!no-)[\w.-]+/g) ?? [];
+  return flags.map((f) => f.trim().replaceAll('"', "")).join(" ");
+}
+
+function cpuInfoField(field: string): string | undefined {
+  const info = readSys("/proc/cpuinfo");
+  return info?.match(new RegExp(`^${field}\\s*:\\s*(.+)$`, "m"))?.[1].trim();
+}
+
+let fingerprint: HostFingerprint | null = null;
+
+export function hostFingerprint(): HostFingerprint {
+  if (fingerprint) return fingerprint;
+  const cpu = "/sys/devices/system/cpu";
+  const noTurbo = readSys(`${cpu}/intel_pstate/no_turbo`);
+  const boost = readSys(`${cpu}/cpufreq/boost`);
+  const smt = readSys(`${cpu}/smt/active`);
+  const maxKHz = readSys(`${cpu}/cpu0/cpufreq/cpuinfo_max_freq`);
+  const compilers = hostCompilers();
+
+  fingerprint = {
+    hostname: hostname(),
+    cpuModel: cpuInfoField("model name") ?? cpus()[0]?.model ?? "unknown",
+    arch: arch(),
+    logicalCpus: cpus().length,
+    microcode: cpuInfoField("microcode"),
+    governor: readSys(`${cpu}/cpu0/cpufreq/scaling_governor`) ?? undefined,
+    smt: smt === null ? undefined : smt === "1",
+    turbo: noTurbo !== null ? noTurbo === "0" : boost !== null ? boost === "1" : undefined,
+    maxMHz: maxKHz ? Number(maxKHz) / 1000 : undefined,
+    kernel: release(),
+    compilers: Object.fromEntries(compilers.map((tc) => [tc.compiler, compilerVersion(tc.compiler)])),
+    nativeFlags: Object.fromEntries(
+      compilers.flatMap((tc) => {
+        const resolved = resolveNative(tc.compiler);
+        return resolved ? [[tc.compiler, resolved]] : [];
+      })
+    ),
+  };
+  return fingerprint;
+}
+
+let calibration: Promise<Calibration | undefined> | null = null;
+
+// memoized: the cli runs it up front, the runner picks up the same numbers.
+// undefined when disabled or the reference kernel can't be built
+export function calibrate(config: CalibrationConfig): Promise<Calibration | undefined> {
+  if (!config.enabled) return Promise.resolve(undefined);
+  calibration ??= runCalibration(config);
+  return calibration;
+}
+
+async function runCalibration(config: CalibrationConfig): Promise<Calibration | undefined> {
+  const tc = availableToolchains(TOOLCHAINS)[0];
+  if (!tc) return undefined;
+  const build = await farmBuild({ ...tc, pgo: false }, REFERENCE_KERNEL, []);
+  if (!build.success) return undefined;
+
+  return getTimedScheduler(SCHEDULER_CONFIG).runTimedMany(1, async (cpus) => {
+    const run = (args: string[]) =>
+      runCommand(build.binary, args, { timeout: 120000, cpus, sandbox: SANDBOX_CONFIG });
+
+    const inProcess = await run([String(config.iterations), String(config.loops)]);
+    if (inProcess.exitCode !== 0) return undefined;
+    const samplesNs = [...inProcess.stdout.matchAll(/^sample (\d+)/gm)].map((m) => Number(m[1]));
+    const resolution = Number(inProcess.stdout.match(/^resolution (\d+)/m)?.[1] ?? 0);
+    if (samplesNs.length < 2) return undefined;
+
+    const processMs: number[] = [];
+    for (let i = 0; i < config.processRuns; i++) {
+      const start = performance.now();
+      const r = await run(["1", String(config.loops)]);
+      if (r.exitCode !== 0) return undefined;
+      if (i > 0) processMs.push(r.usage?.wallMs ?? performance.now() - start); // first run is warmup, as with tests
+    }
+
+    const peaks = await measurePeaks(tc, cpus, ROOFLINE_CONFIG);
+    const warm = samplesNs.slice(1);
+    const referenceNs = median(warm);
+    const harnessJitter = relativeMad(warm);
+    const processJitter = relativeMad(processMs);
+    return {
+      timerResolutionNs: resolution,
+      referenceMs: referenceNs / 1e6,
+      harnessJitter,
+      processJitter,
+      estimatedGHz: referenceNs > 0 ? config.loops / referenceNs : 0,
+      frequencyRamp: referenceNs > 0 ? samplesNs[0] / referenceNs : 1,
+      noiseFloor: {
+        harness: config.noiseMultiplier * harnessJitter,
+        process: config.noiseMultiplier * processJitter,
+      },
+      peaks,
+    };
+  });
+}
+
+// true when a speedup is within the calibrated noise for its timing mode; short
+// kernels also pay for the timer's resolution
+export function belowNoiseFloor(
+  cal: Calibration,
+  mode: "process" | "harness",
+  speedup: number,
+  timeMs: number
+): boolean {
+  const resolutionFloor = timeMs > 0 ? (2 * cal.timerResolutionNs) / (timeMs * 1e6) : 0;
+  const floor = Math.max(cal.noiseFloor[mode], resolutionFloor);
+  return speedup > 0 && Math.abs(Math.log(speedup)) < Math.log1p(floor);
+}
@@ -0,0 +1,60 @@
+// process spawning shared by the runner, toolchain builds and measurements
+
+import { spawn } from "child_process";
+import { tmpdir } from "os";
+import type { Readable } from "stream";
+import { pinnedCommand } from "./scheduler";
+import {
+  parseResourceUsage,
+  sandboxArgs,
+  sandboxHelper,
+  type ResourceUsage,
+  type SandboxConfig,
+} from "./sandbox";
+
+export type CommandResult = { stdout: string; stderr: string; exitCode: number; usage?: ResourceUsage };
+
+export async function runCommand(
+  cmd: string,
+  args: string[],
+  options?: {
+    timeout?: number;
+    input?: string;
+    cpus?: number[] | null;
+    env?: Record<string, string>;
+    sandbox?: SandboxConfig; // untrusted binaries: rlimits, isolation and rusage
+  }
+): Promise<CommandResult> {
+  const sandbox = options?.sandbox?.enabled ? await sandboxHelper() : null;
+  const wrapped = sandbox ? { cmd: sandbox, args: sandboxArgs(options!.sandbox!, cmd, args) } : { cmd, args };
+  const pinned = pinnedCommand(wrapped.cmd, wrapped.args, options?.cpus ?? null);
+  return new Promise((resolve) => {
+    const proc = spawn(pinned.cmd, pinned.args, {
+      timeout: options?.timeout ?? 30000,
+      env: options?.env ? { ...process.env, ...options.env } : undefined,
+      // fd 3 carries the sandbox's rusage line; sandboxed programs run outside the repo
+      stdio: sandbox ? ["pipe", "pipe", "pipe", "pipe"] : "pipe",
+      cwd: sandbox ? tmpdir() : undefined,
+    });
+
+    let stdout = "";
+    let stderr = "";
+    let usage = "";
+
+    proc.stdout!.on("data", (data) => (stdout += data.toString()));
+    proc.stderr!.on("data", (data) => (stderr += data.toString()));
+    if (sandbox) (proc.stdio[3] as Readable).on("data", (data) => (usage += data.toString()));
+
+    // always close stdin so programs that read it never wait for more
+    proc.stdin!.on("error", () => {});
+    proc.stdin!.end(options?.input ?? "");
+
+    proc.on("close", (code) => {
+      resolve({ stdout, stderr, exitCode: code ?? -1, usage: usage ? parseResourceUsage(usage) : undefined });
+    });
+
+    proc.on("error", (err) => {
+      resolve({ stdout, stderr: err.message, exitCode: -1 });
+    });
+  });
+}
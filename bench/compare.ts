@@ -0,0 +1,71 @@
+#!/usr/bin/env bun
+// regression compare between stored runs
+//   bun run compare <suite>                      list indexed versions and hosts
+//   bun run compare <suite> <a>[@host] <b>[@host] diff per (model, test), exit 1 on a regression
+//   bun run compare <suite> --trend              write the trend series for the visualizer
+
+import { writeFile } from "fs/promises";
+import { updateRunIndex } from "./run-index";
+import { diffRuns, parseSelector, selectRuns, trendSeries, type PairDiff } from "./regression";
+
+const VISUALIZER_TRENDS = "../visualizer/data/benchmark-trends.json";
+
+const pct = (x: number) => `${(x * 100).toFixed(0)}%`;
+
+function formatDiff(d: PairDiff): string {
+  const ci = d.speedupRatioCI ? ` [${d.speedupRatioCI[0].toFixed(2)}, ${d.speedupRatioCI[1].toFixed(2)}]` : "";
+  return [
+    d.status.padEnd(10),
+    `${d.model} / ${d.testId}`.padEnd(48),
+    `${d.a.medianSpeedup.toFixed(2)}x -> ${d.b.medianSpeedup.toFixed(2)}x`.padEnd(20),
+    `(${d.speedupRatio.toFixed(2)}${ci})`.padEnd(22),
+    `pass ${pct(d.a.passRate)} -> ${pct(d.b.passRate)}`,
+    `n=${d.a.samples}/${d.b.samples}`,
+  ].join(" ");
+}
+
+async function main() {
+  const [suiteId, ...rest] = process.argv.slice(2);
+  if (!suiteId) {
+    console.error("usage: bun run compare <suite> [<a>[@host] <b>[@host] | --trend]");
+    process.exit(2);
+  }
+
+  const runs = await updateRunIndex();
+
+  if (rest[0] === "--trend") {
+    const trends = trendSeries(runs, suiteId);
+    await writeFile(VISUALIZER_TRENDS, JSON.stringify(trends, null, 2));
+    console.log(`${trends.series.length} series over ${trends.versions.length} versions -> ${VISUALIZER_TRENDS}`);
+    return;
+  }
+
+  if (rest.length < 2) {
+    for (const v of trendSeries(runs, suiteId).versions) {
+      console.log(`${v.version.padEnd(24)} ${v.timestamp}  ${v.host ?? "(no host recorded)"}`);
+    }
+    return;
+  }
+
+  const [a, b] = rest.map(parseSelector);
+  const before = selectRuns(runs, suiteId, a);
+  const after = selectRuns(runs, suiteId, b);
+  for (const [s, found] of [[rest[0], before], [rest[1], after]] as const) {
+    if (found.length === 0) {
+      console.error(`no runs of ${suiteId} match ${s}`);
+      process.exit(2);
+    }
+  }
+
+  const diffs = diffRuns(before, after);
+  for (const d of diffs) console.log(formatDiff(d));
+  const regressed = diffs.filter((d) => d.status === "regressed").length;
+  const improved = diffs.filter((d) => d.status === "improved").length;
+  console.log(`\n${diffs.length} pairs: ${regressed} regressed, ${improved} improved`);
+  if (regressed > 0) process.exit(1);
+}
+
+main().catch((e) => {
+  console.error(e);
+  process.exit(2);
+});
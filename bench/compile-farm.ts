@@ -0,0 +1,192 @@
+// content-addressed compile farm
+// every build is keyed by a hash of source + toolchain + flags, so identical
+// model outputs (common at low temperature) are compiled once and shared.
+// builds run in a tmpfs scratch dir on a worker pool sized to the host, and
+// the least recently used ones are evicted once the farm outgrows its cap
+
+import { createHash } from "crypto";
+import { mkdir, readdir, readFile, rename, rm, stat, utimes, writeFile } from "fs/promises";
+import { accessSync, constants as fsConstants, existsSync } from "fs";
+import { join, resolve } from "path";
+import { cpus, tmpdir, userInfo } from "os";
+import { compilerVersion } from "./baseline-cache";
+import { buildWithToolchain, sourceFileName, type Toolchain } from "./toolchain";
+import { getTimedScheduler } from "./scheduler";
+import { COMPILE_FARM_CONFIG, SCHEDULER_CONFIG } from "./constants";
+
+export type FarmBuild = {
+  success: boolean;
+  error?: string;
+  source: string; // content-addressed copy of the source that was built
+  binary: string;
+  cached: boolean; // true when an identical build already existed
+  compileMs?: number; // of the build that produced the binary, also for cached ones
+};
+
+// written next to the binary so a cached build still knows what it cost
+const BUILD_INFO = "build.json";
+
+async function readCompileMs(dir: string): Promise<number | undefined> {
+  try {
+    return (JSON.parse(await readFile(join(dir, BUILD_INFO), "utf-8")) as { compileMs?: number }).compileMs;
+  } catch {
+    return undefined;
+  }
+}
+
+function scratchRoot(): string {
+  if (COMPILE_FARM_CONFIG.scratchDir) return resolve(COMPILE_FARM_CONFIG.scratchDir);
+  // prefer tmpfs so builds never touch the disk
+  try {
+    accessSync("/dev/shm", fsConstants.W_OK);
+    return join("/dev/shm", `optibench-${userInfo().username}`);
+  } catch {
+    return join(tmpdir(), `optibench-${userInfo().username}`);
+  }
+}
+
+const root = scratchRoot();
+const inFlight = new Map<string, Promise<FarmBuild>>();
+
+// worker pool shared by every build, whoever asked for it; sized lazily so
+// importing this module doesn't create the scheduler
+let workers = 0;
+let active = 0;
+const queue: Array<() => void> = [];
+
+async function withWorker<T>(fn: () => Promise<T>): Promise<T> {
+  if (workers === 0) {
+    workers =
+      COMPILE_FARM_CONFIG.workers ||
+      (getTimedScheduler(SCHEDULER_CONFIG).compileCpus?.length ?? cpus().length);
+  }
+  if (active >= workers) await new Promise<void>((resolve) => queue.push(resolve));
+  active++;
+  try {
+    return await fn();
+  } finally {
+    active--;
+    queue.shift()?.();
+  }
+}
+
+// keys handed out by this process; their binaries may still be run
+const used = new Set<string>();
+let newBuilds = 0;
+let prunedAt: number | null = null; // newBuilds at the last check
+let pruning: Promise<void> | null = null;
+
+async function entryBytes(path: string): Promise<number> {
+  const info = await stat(path);
+  if (!info.isDirectory()) return info.size;
+  const sizes = await Promise.all((await readdir(path)).map((name) => entryBytes(join(path, name))));
+  return sizes.reduce((sum, n) => sum + n, 0);
+}
+
+// <root>/<2 hex>/<key>; a dir's mtime is its last use (hits touch it).
+// leftover .tmp- dirs of crashed builds go with the old entries
+async function pruneFarm() {
+  const { maxMb, keepRecentMinutes } = COMPILE_FARM_CONFIG;
+  if (!maxMb || !existsSync(root)) return;
+  const recent = Date.now() - keepRecentMinutes * 60_000;
+  const entries: Array<{ key: string; path: string; mtimeMs: number; bytes: number }> = [];
+  for (const prefix of await readdir(root)) {
+    for (const name of await readdir(join(root, prefix)).catch(() => [])) {
+      const path = join(root, prefix, name);
+      try {
+        entries.push({ key: name, path, mtimeMs: (await stat(path)).mtimeMs, bytes: await entryBytes(path) });
+      } catch {
+        // removed by another process meanwhile
+      }
+    }
+  }
+
+  let total = entries.reduce((sum, e) => sum + e.bytes, 0);
+  for (const e of entries.sort((a, b) => a.mtimeMs - b.mtimeMs)) {
+    if (total <= maxMb * 1024 * 1024) break;
+    if (used.has(e.key) || e.mtimeMs > recent) continue;
+    await rm(e.path, { recursive: true, force: true });
+    total -= e.bytes;
+  }
+}
+
+function maybePrune() {
+  if (prunedAt !== null && newBuilds - prunedAt < COMPILE_FARM_CONFIG.pruneEveryBuilds) return;
+  prunedAt = newBuilds;
+  pruning ??= pruneFarm()
+    .catch(() => {})
+    .finally(() => (pruning = null));
+}
+
+// a pgo binary also depends on what it trained on
+export function buildKey(tc: Toolchain, code: string, extraFlags: string[], trainingInput?: string): string {
+  return createHash("sha256")
+    .update(
+      JSON.stringify({
+        code,
+        compiler: compilerVersion(tc.compiler),
+        flags: [...tc.flags, ...extraFlags],
+        pgo: tc.pgo ?? false,
+        ...(tc.pgo && trainingInput !== undefined ? { trainingInput } : {}),
+      })
+    )
+    .digest("hex")
+    .slice(0, 32);
+}
+
+export function farmBuild(
+  tc: Toolchain,
+  code: string,
+  extraFlags: string[] = [],
+  trainingInput?: string // stdin for the pgo training run; ignored without pgo
+): Promise<FarmBuild> {
+  const key = buildKey(tc, code, extraFlags, trainingInput);
+  const dir = join(root, key.slice(0, 2), key);
+  const source = join(dir, sourceFileName(tc));
+  const binary = join(dir, "prog");
+  used.add(key);
+  maybePrune();
+
+  // identical code already built (or failed) by another job in this run
+  const pending = inFlight.get(key);
+  if (pending) return pending.then((b) => ({ ...b, cached: true }));
+
+  const promise = (async (): Promise<FarmBuild> => {
+    // or by an earlier run, as long as the scratch dir survived
+    if (existsSync(binary)) {
+      const now = new Date();
+      await utimes(dir, now, now).catch(() => {});
+      return { success: true, source, binary, cached: true, compileMs: await readCompileMs(dir) };
+    }
+
+    return withWorker(async () => {
+      // build in a private dir and rename it into place, so readers never see
+      // a half-written binary. pgo profiles live inside it too
+      const tmp = `${dir}.tmp-${process.pid}-${Math.random().toString(36).slice(2)}`;
+      await mkdir(tmp, { recursive: true });
+      const tmpSource = join(tmp, sourceFileName(tc));
+      await writeFile(tmpSource, code);
+      const result = await buildWithToolchain(tc, tmpSource, join(tmp, "prog"), extraFlags, trainingInput);
+
+      if (!result.success) {
+        await rm(tmp, { recursive: true, force: true });
+        // diagnostics name "main.c" / "main.cpp" rather than the scratch path (it's fed back to models)
+        const error = result.error?.replaceAll(`${tmp}/`, "");
+        return { success: false, error, source, binary, cached: false, compileMs: result.compileMs };
+      }
+      await writeFile(join(tmp, BUILD_INFO), JSON.stringify({ compileMs: result.compileMs }));
+      newBuilds++;
+
+      try {
+        await rename(tmp, dir);
+      } catch {
+        // someone else (another process) finished the same build first
+        await rm(tmp, { recursive: true, force: true });
+      }
+      return { success: true, source, binary, cached: false, compileMs: result.compileMs };
+    });
+  })();
+
+  inFlight.set(key, promise);
+  return promise;
+}
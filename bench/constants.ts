@@ -1,9 +1,191 @@
 export const OUTPUT_DIRECTORY = "./results";
+export const CACHE_DIRECTORY = "./results/cache"; // skipped by update-visualizer
 
 export const MAX_CONCURRENCY = 40;
 export const TEST_RUNS_PER_MODEL = 30;
 export const TIMEOUT_SECONDS = 400;
 export const STAGGER_DELAY_MS = 150;
+export const PIPELINE_QUEUE_CAPACITY = 64; // candidates waiting in front of each pipeline stage
+
+// model request budgets per provider (see providerKey in rate-limit.ts). a 429
+// pauses the provider for its Retry-After and halves the rate until requests
+// succeed again; 429s, 5xx and network errors are retried with backoff
+export const RATE_LIMIT_CONFIG = {
+  providers: {
+    "openrouter:free": { requestsPerMinute: 20, burst: 4 },
+    openrouter: { requestsPerMinute: 600, burst: 40 },
+    google: { requestsPerMinute: 150, burst: 10 },
+  },
+  fallback: { requestsPerMinute: 60, burst: 10 },
+  retry: { maxAttempts: 6, baseDelayMs: 2000, maxDelayMs: 120000 },
+};
+
+// results are appended to results-<ts>.ndjson as they finish; a crash loses at
+// most one batch
+export const RESULTS_LOG_CONFIG = {
+  flushEvery: 16,
+  flushIntervalMs: 2000,
+};
+
+// benchmark sampling - discard warmup runs, then keep sampling until the 95% CI
+// on the median is within targetRelativeCI of it or the time budget runs out
+export const SAMPLING_CONFIG = {
+  warmupRuns: 1,
+  minSamples: 5, // per-test benchmarkIterations overrides this
+  maxSamples: 50,
+  targetRelativeCI: 0.02,
+  timeBudgetMs: 30000,
+};
+
+// reference kernel timed before every run: timer resolution, jitter and clock.
+// a speedup within noiseMultiplier * jitter (or the timer's resolution) of 1x
+// is flagged belowNoiseFloor
+export const CALIBRATION_CONFIG = {
+  enabled: true,
+  iterations: 30,
+  processRuns: 10,
+  loops: 50_000_000,
+  noiseMultiplier: 3,
+};
+
+// host roofs measured with the calibration: fma and integer chains for the
+// compute peaks, a stream triad over 3 x 64 MiB for bandwidth. harness specs
+// that declare flops / ops / bytes are scored as percent of roofline
+export const ROOFLINE_CONFIG = {
+  enabled: true,
+  loops: 20_000_000,
+  repeats: 3,
+  streamDoubles: 1 << 23,
+  passes: 10,
+};
+
+// regression compare (bun run compare): a median speedup change needs
+// minSamples correct results per side, pass-rate changes |z| > zCritical
+export const COMPARE_CONFIG = {
+  minSamples: 3,
+  zCritical: 1.96,
+};
+
+// compile wall time, section sizes and time-to-main of the primary build. a
+// candidate over a cap ranks as a failure (0 = no cap); otherwise each
+// candidate / baseline ratio above 1 divides its ranked speedup by
+// ratio^penalty, so 10x the loaded bytes at size 0.1 ranks a 2x as 1.59x
+export const FOOTPRINT_CONFIG = {
+  enabled: true,
+  startupRuns: 10,
+  caps: { compileMs: 60_000, sizeRatio: 32, startupDeltaMs: 20 },
+  penalties: { compile: 0.05, size: 0.1, startup: 0 },
+};
+
+// distributed mode (--workers): agents started with `bun run worker` listen on
+// port and both sides read the shared secret from tokenEnv. queueDepth
+// candidates per worker slot are in flight, so idle workers can steal. a
+// worker that vanishes without closing its sockets (power loss, dropped
+// tunnel) is caught by tcp keepalive, a /info heartbeat while it has work
+// (heartbeatMisses in a row), or at worst requestTimeoutMs per measurement
+export const WORKER_CONFIG = {
+  port: 7070,
+  tokenEnv: "OPTIBENCH_WORKER_TOKEN",
+  queueDepth: 2,
+  requestTimeoutMs: 60 * 60_000,
+  keepAliveMs: 30_000,
+  heartbeatMs: 30_000,
+  heartbeatTimeoutMs: 10_000,
+  heartbeatMisses: 3,
+};
+
+// timed runs are exclusive: one per physical core, pinned with taskset.
+// timingCpus null = kernel isolcpus if set, else every physical core but the first
+export const SCHEDULER_CONFIG = {
+  timingCpus: null as number[] | null,
+  excludeSmtSiblings: true,
+};
+
+// content-addressed compile farm. scratchDir null = /dev/shm when writable,
+// else the os temp dir; workers 0 = one per non-timing cpu. entries persist
+// across runs up to maxMb (tmpfs is ram, 0 = no cap): checked on the first
+// build and every pruneEveryBuilds new ones, least recently used first, never
+// touching what this process handed out or anything used in keepRecentMinutes
+export const COMPILE_FARM_CONFIG = {
+  scratchDir: null as string | null,
+  workers: 0,
+  maxMb: 2048,
+  pruneEveryBuilds: 200,
+  keepRecentMinutes: 10,
+};
+
+// every run of a test binary (baseline or candidate) goes through the sandbox
+// wrapper; fileSizeMb caps each file written, 0 for the other limits = none
+export const SANDBOX_CONFIG = {
+  enabled: true,
+  addressSpaceMb: 4096,
+  cpuSeconds: 300,
+  fileSizeMb: 64,
+  isolateNetwork: true,
+};
+
+// differential correctness: candidates must match the baseline at every oracle
+// size and, for tests with a driver, on `seeds` random inputs per size.
+// numeric output may differ by max(absolute, relative * |expected|)
+export const ORACLE_CONFIG = {
+  enabled: true,
+  seeds: 8,
+  tolerance: { relative: 1e-6, absolute: 1e-9 },
+};
+
+// feedback rounds after the first answer: compile errors, output diffs or
+// timing + hot functions go back to the model, the best verified round counts.
+// 0 keeps the single-shot numbers
+export const REFINE_CONFIG = {
+  rounds: 0,
+  profile: true,
+  maxFeedbackChars: 4000,
+};
+
+// -S plus loop vectorize / unroll remarks for the baseline and each candidate
+// on the primary toolchain: vector width, loops vectorized, kernel size
+export const CODEGEN_CONFIG = {
+  enabled: true,
+  maxAsmLines: 400,
+  maxFunctions: 4,
+};
+
+// hardware counters via `perf stat`, one extra run per binary when enabled.
+// events the host pmu lacks are skipped; vectorEvents are summed
+export const PERF_CONFIG = {
+  enabled: false,
+  events: [
+    "cycles",
+    "instructions",
+    "L1-dcache-load-misses",
+    "LLC-load-misses",
+    "dTLB-load-misses",
+    "branch-misses",
+  ],
+  vectorEvents: [
+    // intel
+    "fp_arith_inst_retired.128b_packed_double",
+    "fp_arith_inst_retired.128b_packed_single",
+    "fp_arith_inst_retired.256b_packed_double",
+    "fp_arith_inst_retired.256b_packed_single",
+    "fp_arith_inst_retired.512b_packed_double",
+    "fp_arith_inst_retired.512b_packed_single",
+    // amd zen
+    "fp_ret_sse_avx_ops.all",
+  ],
+};
+
+// compiler/flag matrix - baseline and candidate are both built with each
+// toolchain and compared like for like. the first installed one is primary and
+// fills the top-level speedup fields
+export const TOOLCHAINS = [
+  { id: "gcc-O3-native", compiler: "gcc", flags: ["-O3", "-march=native"] },
+  { id: "clang-O3-native", compiler: "clang", flags: ["-O3", "-march=native"] },
+  { id: "gcc-O2", compiler: "gcc", flags: ["-O2"] },
+  { id: "clang-O2", compiler: "clang", flags: ["-O2"] },
+  // { id: "gcc-O3-native-lto-pgo", compiler: "gcc", flags: ["-O3", "-march=native", "-flto"], pgo: true },
+  // { id: "clang-O3-native-lto-pgo", compiler: "clang", flags: ["-O3", "-march=native", "-flto"], pgo: true },
+];
 
 // dry run config - uses free models with fewer runs
 export const DRY_RUN_CONFIG = {
@@ -15,12 +197,14 @@ export const DRY_RUN_CONFIG = {
 
 import { type LanguageModel } from "ai";
 import { openrouter } from "@openrouter/ai-sdk-provider";
+import type { ModelPricing } from "./cost";
 
 export type RunnableModel = {
   name: string;
   llm: LanguageModel;
   providerOptions?: any;
   reasoning?: boolean;
+  pricing?: ModelPricing; // for providers that don't report the billed cost
 };
 
 // Include "usage" so we can log cost
@@ -55,26 +239,30 @@ export const freeModels: RunnableModel[] = [
   },
 ];
 
-// google models via direct api key
+// google models via direct api key; list prices, the api doesn't report cost
 import { google } from "@ai-sdk/google";
 
 export const googleModels: RunnableModel[] = [
   {
     name: "gemini-2.5-flash",
     llm: google("gemini-2.5-flash-preview-05-20"),
+    pricing: { inputPerMTok: 0.3, outputPerMTok: 2.5 },
   },
   {
     name: "gemini-2.5-pro",
     llm: google("gemini-2.5-pro-preview-06-05"),
+    pricing: { inputPerMTok: 1.25, outputPerMTok: 10 },
     reasoning: true,
   },
   {
     name: "gemini-2.0-flash",
     llm: google("gemini-2.0-flash"),
+    pricing: { inputPerMTok: 0.1, outputPerMTok: 0.4 },
   },
   {
     name: "gemini-2.0-flash-lite",
     llm: google("gemini-2.0-flash-lite"),
+    pricing: { inputPerMTok: 0.075, outputPerMTok: 0.3 },
   },
 ];
 
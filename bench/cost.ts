@@ -0,0 +1,25 @@
+// generation cost
+// openrouter reports what each request was billed when usage accounting is on
+// (see defaultProviderOptions); other providers are priced from token counts
+
+import type { LanguageModelUsage, ProviderMetadata } from "ai";
+
+export type ModelPricing = {
+  inputPerMTok: number; // usd per million prompt tokens
+  outputPerMTok: number; // usd per million completion tokens, reasoning included
+};
+
+// undefined when the provider reports no cost and the model has no pricing
+export function requestCostUsd(
+  response: { usage?: LanguageModelUsage; providerMetadata?: ProviderMetadata },
+  pricing?: ModelPricing
+): number | undefined {
+  const billed = (response.providerMetadata?.openrouter as any)?.usage?.cost;
+  if (typeof billed === "number") return billed;
+
+  const { inputTokens, outputTokens, totalTokens } = response.usage ?? {};
+  if (!pricing || inputTokens === undefined || outputTokens === undefined) return undefined;
+  // some providers leave thinking tokens out of outputTokens but not the total
+  const billedOutput = Math.max(outputTokens, (totalTokens ?? 0) - inputTokens);
+  return (inputTokens * pricing.inputPerMTok + billedOutput * pricing.outputPerMTok) / 1e6;
+}
@@ -0,0 +1,89 @@
+// visualizer detail data
+// one compact cell per (model, test) goes in the bundled index; the full
+// results of each pair go in their own shard under public/, fetched when the
+// cell is opened, with the generated source gzipped
+
+import { createHash } from "crypto";
+import { mkdir, rm, writeFile } from "fs/promises";
+import { join } from "path";
+import { gzipSync } from "zlib";
+import { median } from "./sampling";
+import type { OptimizationResult } from "./optimization-runner";
+
+export type DetailCell = {
+  model: string;
+  testId: string;
+  testName: string;
+  samples: number;
+  compiled: number;
+  correct: number;
+  speedup: number; // median over correct samples, 0 when none
+  bestSpeedup: number;
+  representative: number; // index into the shard's results, the sample closest to the median
+  shard: string; // file name under the shard dir, without .json
+};
+
+// stable and url-safe; the hash keeps "a/b" and "a_b" apart
+export function shardName(model: string, testId: string): string {
+  const slug = `${model}__${testId}`.replace(/[^A-Za-z0-9._-]/g, "_");
+  const hash = createHash("sha1").update(`${model}\t${testId}`).digest("hex").slice(0, 8);
+  return `${slug}-${hash}`;
+}
+
+const gzipBase64 = (text: string) => gzipSync(text, { level: 9 }).toString("base64");
+
+export async function writeDetailShards(
+  results: OptimizationResult[],
+  metadata: unknown,
+  indexFile: string,
+  shardDir: string
+): Promise<{ cells: number; shards: number }> {
+  const pairs = new Map<string, OptimizationResult[]>();
+  for (const r of results) {
+    const key = `${r.model}\t${r.testId}`;
+    (pairs.get(key) ?? pairs.set(key, []).get(key)!).push(r);
+  }
+
+  // shards of an earlier run would otherwise linger next to the new ones
+  await rm(shardDir, { recursive: true, force: true });
+  await mkdir(shardDir, { recursive: true });
+
+  const cells: DetailCell[] = [];
+  for (const group of pairs.values()) {
+    group.sort((a, b) => (a.sample ?? 0) - (b.sample ?? 0));
+    const { model, testId, testName } = group[0];
+    const shard = shardName(model, testId);
+    const speedups = group.filter((r) => r.correct).map((r) => r.speedup);
+    const mid = median(speedups);
+
+    let representative = 0;
+    group.forEach((r, i) => {
+      const best = group[representative];
+      if (r.correct && (!best.correct || Math.abs(r.speedup - mid) < Math.abs(best.speedup - mid))) {
+        representative = i;
+      }
+    });
+
+    cells.push({
+      model,
+      testId,
+      testName,
+      samples: group.length,
+      compiled: group.filter((r) => r.compiled).length,
+      correct: speedups.length,
+      speedup: mid,
+      bestSpeedup: Math.max(0, ...speedups),
+      representative,
+      shard,
+    });
+
+    const shardResults = group.map(({ optimizedCode, ...r }) => ({
+      ...r,
+      optimizedCodeGz: optimizedCode ? gzipBase64(optimizedCode) : undefined,
+    }));
+    await writeFile(join(shardDir, `${shard}.json`), JSON.stringify({ model, testId, results: shardResults }));
+  }
+
+  await writeFile(indexFile, JSON.stringify({ format: "sharded", cells, metadata }, null, 2));
+  return { cells: cells.length, shards: pairs.size };
+}
@@ -0,0 +1,153 @@
+// build and startup footprint
+// compile wall time, section sizes and time-to-main of a build, so a "win"
+// that ships a 10k-line precomputed table pays for it in the rankings: over a
+// cap it ranks as a failure, otherwise the growth over the baseline discounts
+// its ranked speedup
+
+import { stat } from "fs/promises";
+import { runCommand } from "./command";
+import { farmBuild } from "./compile-farm";
+import { getTimedScheduler } from "./scheduler";
+import { median } from "./sampling";
+import type { Toolchain } from "./toolchain";
+import { SANDBOX_CONFIG, SCHEDULER_CONFIG } from "./constants";
+
+export type FootprintConfig = {
+  enabled: boolean;
+  startupRuns: number; // time-to-main samples per binary, after one warmup
+  caps: { compileMs: number; sizeRatio: number; startupDeltaMs: number }; // 0 = no cap
+  penalties: { compile: number; size: number; startup: number }; // exponents on the candidate / baseline ratio
+};
+
+export type BinarySize = {
+  text: number; // .text, the code
+  rodata: number; // constant tables land here
+  data: number;
+  bss: number;
+  file: number; // bytes on disk
+};
+
+export type Footprint = {
+  compileMs?: number; // wall time of the compiler (both builds with pgo)
+  size?: BinarySize;
+  startupMs?: number; // median exec -> main, static initialisers and relocation included
+};
+
+// what leaves the disk when the binary is loaded; bss costs nothing until touched
+export const loadedBytes = (s: BinarySize) => s.text + s.rodata + s.data;
+
+// size -A prints one line per section: name, size, address
+export async function binarySize(binary: string): Promise<BinarySize | undefined> {
+  const run = await runCommand("size", ["-A", "-d", binary]);
+  if (run.exitCode !== 0) return undefined;
+  const section = (name: string) => Number(run.stdout.match(new RegExp(`^\\${name}\\s+(\\d+)`, "m"))?.[1] ?? 0);
+  return {
+    text: section(".text"),
+    rodata: section(".rodata"),
+    data: section(".data"),
+    bss: section(".bss"),
+    file: (await stat(binary)).size,
+  };
+}
+
+const SPAWN_ENV = "OPTIBENCH_SPAWN_NS";
+const STARTUP_PREFIX = "optibench_startup_ns";
+
+// the program with its main renamed, so everything before main (loader,
+// relocations, constructors) still runs but the work doesn't. the stub
+// reports the monotonic time since the parent stamped the spawn; node's
+// hrtime reads the same clock
+export function startupDriver(code: string): string {
+  return `#define main optibench_program_main
+${code}
+#undef main
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+int main(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  const char *spawn = getenv("${SPAWN_ENV}");
+  if (!spawn) return 1;
+  long long ns = (long long)now.tv_sec * 1000000000LL + now.tv_nsec - atoll(spawn);
+  printf("${STARTUP_PREFIX} %lld\\n", ns);
+  return 0;
+}
+`;
+}
+
+async function timeToMain(tc: Toolchain, code: string, flags: string[], runs: number): Promise<number | undefined> {
+  const build = await farmBuild({ ...tc, pgo: false }, startupDriver(code), flags);
+  if (!build.success) return undefined;
+  return getTimedScheduler(SCHEDULER_CONFIG).runTimedMany(1, async (cpus) => {
+    const samples: number[] = [];
+    for (let i = 0; i <= runs; i++) {
+      const run = await runCommand(build.binary, [], {
+        timeout: 30000,
+        cpus,
+        env: { [SPAWN_ENV]: String(process.hrtime.bigint()) },
+        sandbox: SANDBOX_CONFIG,
+      });
+      const ns = Number(run.stdout.match(new RegExp(`^${STARTUP_PREFIX} (-?\\d+)`, "m"))?.[1]);
+      if (run.exitCode !== 0 || !Number.isFinite(ns)) return undefined;
+      if (i > 0) samples.push(ns / 1e6); // first run warms the page cache
+    }
+    return median(samples);
+  });
+}
+
+export async function measureFootprint(
+  tc: Toolchain,
+  code: string,
+  build: { binary: string; compileMs?: number },
+  flags: string[],
+  config: FootprintConfig
+): Promise<Footprint> {
+  const [size, startupMs] = await Promise.all([
+    binarySize(build.binary),
+    config.startupRuns > 0 ? timeToMain(tc, code, flags, config.startupRuns) : undefined,
+  ]);
+  return { compileMs: build.compileMs, size, startupMs };
+}
+
+export type FootprintVerdict = {
+  penalty: number; // multiplies the ranked speedup, 1 = none
+  cap?: string; // the first cap exceeded; ranks as a failure
+};
+
+export function footprintVerdict(baseline: Footprint, optimized: Footprint, config: FootprintConfig): FootprintVerdict {
+  const ratio = (a?: number, b?: number) => (a !== undefined && b !== undefined && a > 0 ? b / a : undefined);
+  const compileRatio = ratio(baseline.compileMs, optimized.compileMs);
+  const sizeRatio = ratio(baseline.size && loadedBytes(baseline.size), optimized.size && loadedBytes(optimized.size));
+  const startupRatio = ratio(baseline.startupMs, optimized.startupMs);
+  const startupDelta =
+    baseline.startupMs !== undefined && optimized.startupMs !== undefined ? optimized.startupMs - baseline.startupMs : undefined;
+
+  const { caps, penalties } = config;
+  const cap =
+    caps.compileMs > 0 && (optimized.compileMs ?? 0) > caps.compileMs
+      ? `compile time ${((optimized.compileMs ?? 0) / 1000).toFixed(1)}s over ${(caps.compileMs / 1000).toFixed(0)}s`
+      : caps.sizeRatio > 0 && (sizeRatio ?? 0) > caps.sizeRatio
+        ? `binary ${sizeRatio!.toFixed(1)}x the baseline's, over ${caps.sizeRatio}x`
+        : caps.startupDeltaMs > 0 && (startupDelta ?? 0) > caps.startupDeltaMs
+          ? `time-to-main ${startupDelta!.toFixed(1)} ms over the baseline's, cap ${caps.startupDeltaMs} ms`
+          : undefined;
+
+  // only growth is penalised; a smaller or faster-building candidate isn't rewarded
+  const discount = (r: number | undefined, exponent: number) => (r !== undefined && r > 1 ? r ** -exponent : 1);
+  const penalty =
+    discount(compileRatio, penalties.compile) * discount(sizeRatio, penalties.size) * discount(startupRatio, penalties.startup);
+  return { penalty, cap };
+}
+
+// speedup as the rankings score it: failures and capped candidates at 0
+export function rankedSpeedup(r: {
+  correct: boolean;
+  speedup: number;
+  footprintPenalty?: number;
+  footprintCap?: string;
+}): number {
+  if (!r.correct || r.footprintCap) return 0;
+  return r.speedup * (r.footprintPenalty ?? 1);
+}
@@ -0,0 +1,113 @@
+// persistent generation store
+// a model response only depends on the request, so it is kept under a hash of
+// (model name and id, provider options, system prompt, prompt, temperature,
+// sample) and re-runs on new hosts or with new measurement code skip the network
+
+import { createHash } from "crypto";
+import { writeFile, readFile, mkdir, rename } from "fs/promises";
+import { existsSync } from "fs";
+import { join } from "path";
+import type { LanguageModel } from "ai";
+import type { RunnableModel } from "./constants";
+
+export type GenerationEntry = {
+  key: string;
+  model: string; // display name at the time it was stored
+  modelId: string;
+  testId: string;
+  sample: number;
+  response: string; // raw text, before code extraction
+  code: string | null; // extractCodeFromResponse output
+  tokensUsed: number;
+  usage?: unknown; // the provider's full usage object (input / output / reasoning tokens)
+  costUsd?: number; // billed or priced cost of the request, see requestCostUsd
+  generationMs: number;
+  createdAt: string;
+};
+
+export function languageModelId(llm: LanguageModel): string {
+  return typeof llm === "string" ? llm : `${llm.provider}:${llm.modelId}`;
+}
+
+// effort variants share the provider model id and carry their settings inside
+// the llm, so the runnable name is what tells them apart
+export function modelKeyParts(model: RunnableModel) {
+  return { model: model.name, modelId: languageModelId(model.llm), providerOptions: model.providerOptions ?? null };
+}
+
+// two entries of one model set that would share generation keys would also
+// share (and overwrite) each other's answers
+export function checkDistinctModelKeys(models: RunnableModel[]): void {
+  const seen = new Map<string, RunnableModel>();
+  for (const m of models) {
+    const id = JSON.stringify(modelKeyParts(m));
+    const other = seen.get(id);
+    if (other && other !== m) throw new Error(`Models ${other.name} and ${m.name} would share generation keys`);
+    seen.set(id, m);
+  }
+}
+
+export function generationKey(parts: {
+  model: string;
+  modelId: string;
+  providerOptions: unknown;
+  system: string;
+  prompt: string;
+  temperature: number;
+  sample: number; // distinct samples of the same request get distinct entries
+}): string {
+  return createHash("sha256").update(JSON.stringify(parts)).digest("hex");
+}
+
+const entryFile = (cacheDir: string, key: string) => join(cacheDir, "generations", `${key}.json`);
+
+export async function readGeneration(cacheDir: string, key: string): Promise<GenerationEntry | null> {
+  const file = entryFile(cacheDir, key);
+  if (!existsSync(file)) return null;
+  try {
+    return JSON.parse(await readFile(file, "utf-8")) as GenerationEntry;
+  } catch {
+    return null;
+  }
+}
+
+// in-flight lookups so identical jobs only pay for one generation
+const pending = new Map<string, Promise<GenerationEntry>>();
+
+// `cached` is true when the entry came from disk or another job's request;
+// errors (timeouts, rate limits) propagate and are not stored. without `reuse`
+// the model is always asked and the stored entry replaced, so a new run sees
+// what the provider serves today
+export async function getOrCreateGeneration(
+  cacheDir: string,
+  key: string,
+  reuse: boolean,
+  create: () => Promise<Omit<GenerationEntry, "key" | "createdAt">>
+): Promise<{ entry: GenerationEntry; cached: boolean }> {
+  const inFlight = pending.get(key);
+  if (inFlight) return { entry: await inFlight, cached: true };
+
+  let cached = true;
+  const promise = (async () => {
+    const stored = reuse ? await readGeneration(cacheDir, key) : null;
+    if (stored) return stored;
+
+    cached = false;
+    const created = await create();
+    const entry: GenerationEntry = { ...created, key, createdAt: new Date().toISOString() };
+    const file = entryFile(cacheDir, key);
+    await mkdir(join(cacheDir, "generations"), { recursive: true });
+    // write then rename so a crash never leaves a half-written entry
+    const tmp = `${file}.${process.pid}.tmp`;
+    await writeFile(tmp, JSON.stringify(entry, null, 2));
+    await rename(tmp, file);
+    return entry;
+  })();
+
+  pending.set(key, promise);
+  try {
+    return { entry: await promise, cached };
+  } finally {
+    pending.delete(key);
+  }
+}
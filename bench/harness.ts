@@ -0,0 +1,99 @@
+// in-process timing harness
+// generates a C driver that includes the program source with main() renamed,
+// then times only the kernel call with CLOCK_MONOTONIC_RAW over warm iterations
+
+import type { HarnessWork } from "./roofline";
+
+export type HarnessSpec = {
+  kernel: string; // function under test, models must keep its signature
+  setup: string; // C statements run once before timing (can use the program's macros)
+  reset?: string; // C statements run before every iteration, not timed
+  call: string; // timed statements, wrap results in OPTIBENCH_KEEP() so they aren't dropped
+  iterations?: number; // timed iterations (default 20)
+  warmup?: number; // untimed iterations before sampling (default 3)
+  bytes?: string; // C expression: the least memory traffic one call needs, reported as effective GB/s
+  flops?: string; // C expression: floating-point operations per call (an fma counts 2), for the roofline
+  ops?: string; // C expression: other counted operations per call (compares, integer ops)
+};
+
+const SAMPLE_PREFIX = "optibench_sample";
+const WORK_PREFIX = "optibench_work";
+const WORK_KINDS = ["bytes", "flops", "ops"] as const;
+
+export function harnessIterations(spec: HarnessSpec) {
+  return { iterations: spec.iterations ?? 20, warmup: spec.warmup ?? 3 };
+}
+
+export function generateHarnessDriver(sourcePath: string, spec: HarnessSpec): string {
+  const { iterations, warmup } = harnessIterations(spec);
+
+  // g++ predefines _GNU_SOURCE
+  return `#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#define main optibench_program_main
+#include ${JSON.stringify(sourcePath)}
+#undef main
+
+// force a value (and all pending stores) to be materialized
+#define OPTIBENCH_KEEP(expr) do { \\
+    __typeof__(expr) optibench_keep_v = (expr); \\
+    __asm__ volatile("" : : "m"(optibench_keep_v) : "memory"); \\
+  } while (0)
+
+static inline uint64_t optibench_now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+int main(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+  static uint64_t optibench_samples[${iterations}];
+
+  ${spec.setup}
+
+  for (int optibench_i = 0; optibench_i < ${warmup + iterations}; optibench_i++) {
+    { ${spec.reset ?? ""} }
+    uint64_t optibench_t0 = optibench_now_ns();
+    { ${spec.call} }
+    uint64_t optibench_t1 = optibench_now_ns();
+    if (optibench_i >= ${warmup}) optibench_samples[optibench_i - ${warmup}] = optibench_t1 - optibench_t0;
+  }
+
+  // print after the loop so stdio never lands inside a timed region
+  for (int optibench_i = 0; optibench_i < ${iterations}; optibench_i++) {
+    printf("${SAMPLE_PREFIX} %llu\\n", (unsigned long long)optibench_samples[optibench_i]);
+  }${WORK_KINDS.filter((kind) => spec[kind])
+    .map((kind) => `\n  printf("${WORK_PREFIX} ${kind} %.0f\\n", (double)(${spec[kind]}));`)
+    .join("")}
+  return 0;
+}
+`;
+}
+
+// work per call from the spec's expressions, evaluated at the build's sizes
+export function parseHarnessWork(stdout: string): HarnessWork | undefined {
+  const work: HarnessWork = {};
+  for (const [, kind, amount] of stdout.matchAll(new RegExp(`^${WORK_PREFIX} (\\w+) (\\d+)$`, "gm"))) {
+    if ((WORK_KINDS as readonly string[]).includes(kind)) work[kind as keyof HarnessWork] = Number(amount);
+  }
+  return Object.keys(work).length > 0 ? work : undefined;
+}
+
+// per-iteration kernel times in ms, ignoring anything else the program printed
+export function parseHarnessSamples(stdout: string): number[] {
+  const samples: number[] = [];
+  for (const line of stdout.split("\n")) {
+    const match = line.trim().match(new RegExp(`^${SAMPLE_PREFIX} (\\d+)$`));
+    if (match) samples.push(Number(match[1]) / 1e6);
+  }
+  return samples;
+}
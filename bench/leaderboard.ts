@@ -0,0 +1,68 @@
+// pareto views over the summary rankings
+// which models no other model beats on both speedup and cost (or generation
+// latency), and how reasoning variants of one base model compare
+
+import type { RunnableModel } from "./constants";
+import { languageModelId } from "./generation-cache";
+import type { summaryRankings } from "./results-log";
+
+type Ranking = ReturnType<typeof summaryRankings>[number];
+
+// models not dominated on (lower x, higher geomean speedup)
+export function paretoFront(rankings: Ranking[], x: (r: Ranking) => number | undefined): string[] {
+  const points = rankings
+    .filter((r) => r.testsRun > 0)
+    .map((r) => ({ model: r.model, x: x(r), y: r.geomeanSpeedup }))
+    .filter((p): p is { model: string; x: number; y: number } => p.x !== undefined && Number.isFinite(p.x));
+  return points
+    .filter((p) => !points.some((q) => q.x <= p.x && q.y >= p.y && (q.x < p.x || q.y > p.y)))
+    .sort((a, b) => a.x - b.x)
+    .map((p) => p.model);
+}
+
+// one base model, e.g. "deepseek-v3.1" and "deepseek-v3.1-thinking", or the
+// effort levels of gpt-5: same model id once a "-thinking" suffix is dropped
+export function variantFamily(m: RunnableModel): string {
+  return languageModelId(m.llm).replace(/-thinking\b/, "");
+}
+
+export function leaderboardViews(rankings: Ranking[], models: RunnableModel[]) {
+  const families = new Map<string, RunnableModel[]>();
+  for (const m of models) families.set(variantFamily(m), [...(families.get(variantFamily(m)) ?? []), m]);
+
+  const byModel = new Map(rankings.map((r) => [r.model, r]));
+  const variants = [...families.entries()]
+    .filter(([, members]) => members.length > 1)
+    .map(([family, members]) => {
+      const rows = members
+        .filter((m) => (byModel.get(m.name)?.testsRun ?? 0) > 0)
+        .map((m) => {
+          const r = byModel.get(m.name)!;
+          return {
+            model: m.name,
+            reasoning: m.reasoning ?? false,
+            geomeanSpeedup: r.geomeanSpeedup,
+            averageCostPerTest: r.averageCostPerTest,
+            avgTimeMs: r.avgTimeMs,
+          };
+        })
+        .sort((a, b) => b.geomeanSpeedup - a.geomeanSpeedup);
+      const best = (reasoning: boolean) => rows.find((r) => r.reasoning === reasoning);
+      const [on, off] = [best(true), best(false)];
+      return {
+        family,
+        models: rows,
+        // best reasoning variant over the best plain one, when the family has both
+        reasoningGain: on && off && off.geomeanSpeedup > 0 ? on.geomeanSpeedup / off.geomeanSpeedup : undefined,
+      };
+    })
+    .filter((v) => v.models.length > 1);
+
+  return {
+    pareto: {
+      cost: paretoFront(rankings, (r) => r.averageCostPerTest),
+      latency: paretoFront(rankings, (r) => r.avgTimeMs),
+    },
+    variants,
+  };
+}
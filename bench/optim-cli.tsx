@@ -1,21 +1,21 @@
 #!/usr/bin/env node
 // CLI for running optimization benchmarks
 
-import React, { useEffect, useMemo, useState } from "react";
+import React, { useEffect, useMemo, useRef, useState } from "react";
 import { render, Box, Text, useApp } from "ink";
 import SelectInput from "ink-select-input";
 import TextInput from "ink-text-input";
 import { join, dirname } from "path";
 import { fileURLToPath } from "url";
-import { readdir, readFile, writeFile, mkdir } from "fs/promises";
-import { existsSync } from "fs";
+import type { OptimizationSuite } from "./optimization-runner";
 import {
-  runOptimizationTest,
-  cleanupWorkDir,
-  type OptimizationSuite,
-  type OptimizationResult,
-} from "./optimization-runner";
-import { freeModels, googleModels, DRY_RUN_CONFIG, OUTPUT_DIRECTORY } from "./constants";
+  defaultVersion,
+  findOptimSuites,
+  parseRunArgs,
+  progressTracker,
+  runSession,
+  type ModelStats,
+} from "./run-session";
 
 function ensureRefUnref(stream: any) {
   if (!stream) return stream;
@@ -28,48 +28,19 @@ const stdin = ensureRefUnref(process.stdin as any);
 const stdout = ensureRefUnref(process.stdout as any);
 const stderr = ensureRefUnref(process.stderr as any);
 
-// combine free + google models
-const models = [...freeModels, ...googleModels];
+// same flags as the headless runner (--models, --tests, --variants, --samples, --replay,
+// --reuse-generations, --resume, --dry-run); suite and version are asked for when not given
+const options = parseRunArgs(process.argv.slice(2));
+const { models, replayVersion } = options;
+
+// the table redraws on a timer rather than on every result
+const REDRAW_INTERVAL_MS = 250;
 
 function useBenchRoot() {
   const here = fileURLToPath(import.meta.url);
   return dirname(here);
 }
 
-async function findOptimSuites(testsDir: string) {
-  const entries = await readdir(testsDir, { withFileTypes: true });
-  const files = entries.filter((e) => e.isFile() && e.name.endsWith(".json"));
-  const suites: Array<{ filePath: string; suite: OptimizationSuite }> = [];
-
-  for (const f of files) {
-    try {
-      const filePath = join(testsDir, f.name);
-      const raw = await readFile(filePath, "utf-8");
-      const json = JSON.parse(raw);
-      // check if it's an optimization suite (has tests with 'code' field)
-      if (json?.tests?.[0]?.code) {
-        suites.push({ filePath, suite: json as OptimizationSuite });
-      }
-    } catch {}
-  }
-  return suites;
-}
-
-function formatDefaultVersion() {
-  const d = new Date();
-  return `${d.getFullYear()}-${String(d.getMonth() + 1).padStart(2, "0")}-${String(d.getDate()).padStart(2, "0")}`;
-}
-
-type ModelStats = {
-  testsRun: number;
-  testsTotal: number;
-  compiled: number;
-  correct: number;
-  totalSpeedup: number;
-  avgSpeedup: number;
-  running: boolean;
-};
-
 function ProgressBar({ completed, total }: { completed: number; total: number }) {
   const width = 40;
   const ratio = total > 0 ? completed / total : 0;
@@ -103,17 +74,24 @@ const App: React.FC = () => {
   const [error, setError] = useState<string | null>(null);
   const [suites, setSuites] = useState<Array<{ filePath: string; suite: OptimizationSuite }>>([]);
   const [selectedIndex, setSelectedIndex] = useState<number | null>(null);
-  const [version, setVersion] = useState<string>(formatDefaultVersion());
+  const [version, setVersion] = useState<string>(options.version ?? defaultVersion(options));
   const [stage, setStage] = useState<"pickSuite" | "version" | "running" | "done">("pickSuite");
   const [stats, setStats] = useState<Record<string, ModelStats>>({});
-  const [results, setResults] = useState<OptimizationResult[]>([]);
   const [currentTest, setCurrentTest] = useState<string>("");
+  const [outputDir, setOutputDir] = useState<string>("");
+  const tracker = useRef(progressTracker());
 
   useEffect(() => {
     (async () => {
       try {
         const found = await findOptimSuites(testsDir);
         setSuites(found);
+        // --suite skips the picker, --version the label prompt as well
+        const preset = options.suiteId ? found.findIndex((s) => s.suite.id === options.suiteId) : -1;
+        if (preset >= 0) {
+          setSelectedIndex(preset);
+          setStage(options.version ? "running" : "version");
+        }
         setLoading(false);
       } catch (e) {
         setError((e as Error).message);
@@ -123,162 +101,32 @@ const App: React.FC = () => {
   }, [testsDir]);
 
   useEffect(() => {
-    if (stage === "running" && selectedIndex != null) {
-      (async () => {
-        const entry = suites[selectedIndex];
-        const suite = entry.suite;
-        const workDir = join(benchRoot, ".optim-work");
-        const allResults: OptimizationResult[] = [];
-
-        // init stats
-        const initialStats: Record<string, ModelStats> = {};
-        for (const model of models) {
-          initialStats[model.name] = {
-            testsRun: 0,
-            testsTotal: suite.tests.length,
-            compiled: 0,
-            correct: 0,
-            totalSpeedup: 0,
-            avgSpeedup: 0,
-            running: false,
-          };
-        }
-        setStats(initialStats);
-
-        // run models in parallel (up to 3 concurrent)
-        const MAX_CONCURRENT = 3;
-        const modelQueue = [...models];
-        const activePromises: Promise<void>[] = [];
-
-        const runModelTests = async (model: typeof models[0]) => {
-          setStats((prev) => ({
-            ...prev,
-            [model.name]: { ...prev[model.name], running: true },
-          }));
-
-          for (const test of suite.tests) {
-            setCurrentTest(`${model.name} / ${test.name}`);
-
-            try {
-              const result = await runOptimizationTest({
-                model,
-                test,
-                systemPrompt: suite.systemPrompt,
-                workDir: join(workDir, model.name),
-                silent: true,
-              });
-
-              allResults.push(result);
-              setResults([...allResults]);
-
-              setStats((prev) => {
-                const s = prev[model.name];
-                const newRun = s.testsRun + 1;
-                const newCompiled = s.compiled + (result.compiled ? 1 : 0);
-                const newCorrect = s.correct + (result.correct ? 1 : 0);
-                const newTotalSpeedup = s.totalSpeedup + (result.correct ? result.speedup : 0);
-                return {
-                  ...prev,
-                  [model.name]: {
-                    ...s,
-                    testsRun: newRun,
-                    compiled: newCompiled,
-                    correct: newCorrect,
-                    totalSpeedup: newTotalSpeedup,
-                    avgSpeedup: newCorrect > 0 ? newTotalSpeedup / newCorrect : 0,
-                  },
-                };
-              });
-            } catch (err) {
-              console.error(`Error running ${model.name} on ${test.name}:`, err);
-              setStats((prev) => {
-                const s = prev[model.name];
-                return {
-                  ...prev,
-                  [model.name]: { ...s, testsRun: s.testsRun + 1 },
-                };
-              });
-            }
-          }
-
-          setStats((prev) => ({
-            ...prev,
-            [model.name]: { ...prev[model.name], running: false },
-          }));
-        };
-
-        // process models with concurrency limit
-        while (modelQueue.length > 0 || activePromises.length > 0) {
-          while (activePromises.length < MAX_CONCURRENT && modelQueue.length > 0) {
-            const model = modelQueue.shift()!;
-            const promise = runModelTests(model).then(() => {
-              const idx = activePromises.indexOf(promise);
-              if (idx > -1) activePromises.splice(idx, 1);
-            });
-            activePromises.push(promise);
-          }
-          if (activePromises.length > 0) {
-            await Promise.race(activePromises);
-          }
-        }
-
-        // save results
-        const outputDir = join(OUTPUT_DIRECTORY, suite.id, version);
-        if (!existsSync(outputDir)) {
-          await mkdir(outputDir, { recursive: true });
-        }
-
-        const timestamp = new Date().toISOString().replace(/[:.]/g, "-");
-
-        // create summary for visualizer
-        const modelSummaries = models.map((m) => {
-          const modelResults = allResults.filter((r) => r.model === m.name);
-          const correct = modelResults.filter((r) => r.correct);
-          const avgSpeedup = correct.length > 0
-            ? correct.reduce((sum, r) => sum + r.speedup, 0) / correct.length
-            : 0;
-
-          return {
-            model: m.name,
-            testsRun: modelResults.length,
-            compiled: modelResults.filter((r) => r.compiled).length,
-            correct: correct.length,
-            avgSpeedup,
-            maxSpeedup: correct.length > 0 ? Math.max(...correct.map((r) => r.speedup)) : 0,
-            avgTimeMs: modelResults.reduce((sum, r) => sum + r.duration, 0) / modelResults.length,
-          };
-        }).sort((a, b) => b.avgSpeedup - a.avgSpeedup);
-
-        const summary = {
-          rankings: modelSummaries,
-          metadata: {
-            timestamp: new Date().toISOString(),
-            testSuite: suite.name,
-            suiteId: suite.id,
-            version,
-            totalModels: models.length,
-            totalTests: suite.tests.length,
-          },
-        };
-
-        await writeFile(
-          join(outputDir, `summary-${timestamp}.json`),
-          JSON.stringify(summary, null, 2)
-        );
-
-        await writeFile(
-          join(outputDir, `results-${timestamp}.json`),
-          JSON.stringify({ results: allResults, metadata: summary.metadata }, null, 2)
-        );
-
-        console.log(`\n\nResults saved to: ${outputDir}/`);
-
-        // cleanup
-        await cleanupWorkDir(workDir);
-
+    if (stage !== "running" || selectedIndex == null) return;
+    const t = tracker.current;
+    const redraw = () => {
+      setStats({ ...t.stats });
+      setCurrentTest(t.current());
+    };
+    const timer = setInterval(redraw, REDRAW_INTERVAL_MS);
+
+    runSession({ ...options, version }, suites[selectedIndex].suite, (event) => {
+      t.apply(event);
+      if (event.type === "start") {
+        setCurrentTest("calibrating timer, jitter and clock");
+        setOutputDir(event.outputDir);
+      }
+    })
+      .then(() => {
+        clearInterval(timer);
+        redraw();
         setStage("done");
-      })();
-    }
+      })
+      .catch((e) => {
+        clearInterval(timer);
+        setError((e as Error).message);
+      });
+
+    return () => clearInterval(timer);
   }, [stage, selectedIndex, suites, version, benchRoot]);
 
   if (loading) {
@@ -301,6 +149,8 @@ const App: React.FC = () => {
       <Box flexDirection="column">
         <Text color="cyan" bold>Compiler Optimization Benchmark</Text>
         <Text color="gray">Models: {models.map((m) => m.name).join(", ")}</Text>
+        <Text color="gray">Samples per test: {options.samples.length}</Text>
+        {replayVersion && <Text color="yellow">Replaying stored generations from {replayVersion}</Text>}
         <Box marginTop={1}>
           <Text>Select a test suite:</Text>
         </Box>
@@ -333,7 +183,7 @@ const App: React.FC = () => {
 
   if (stage === "running" || stage === "done") {
     const suite = selectedIndex != null ? suites[selectedIndex]?.suite : null;
-    const totalTests = models.length * (suite?.tests.length ?? 0);
+    const totalTests = Object.values(stats).reduce((sum, s) => sum + s.testsTotal, 0);
     const completedTests = Object.values(stats).reduce((sum, s) => sum + s.testsRun, 0);
 
     const rows = models.map((m) => {
@@ -343,7 +193,9 @@ const App: React.FC = () => {
         progress: s ? `${s.testsRun}/${s.testsTotal}` : "-",
         compiled: s ? `${s.compiled}` : "-",
         correct: s ? `${s.correct}` : "-",
-        speedup: s && s.avgSpeedup > 0 ? `${s.avgSpeedup.toFixed(2)}x` : "-",
+        infra: s ? `${s.infraErrors}` : "-",
+        speedup: s && s.geomeanSpeedup > 0 ? `${s.geomeanSpeedup.toFixed(2)}x` : "-",
+        cost: s && s.costUsd > 0 ? `$${s.costUsd.toFixed(2)}` : "-",
         running: s?.running ?? false,
       };
     });
@@ -361,7 +213,9 @@ const App: React.FC = () => {
             <Text underline>{pad("Progress", 10)}</Text>{"  "}
             <Text underline>{pad("Compiled", 8)}</Text>{"  "}
             <Text underline>{pad("Correct", 7)}</Text>{"  "}
-            <Text underline>{pad("Avg Speedup", 11)}</Text>
+            <Text underline>{pad("Infra", 5)}</Text>{"  "}
+            <Text underline>{pad("Geo Speedup", 11)}</Text>{"  "}
+            <Text underline>{pad("Cost", 8)}</Text>
           </Text>
           {rows.map((r) => (
             <Text key={r.model}>
@@ -369,7 +223,9 @@ const App: React.FC = () => {
               <Text color="gray">{padLeft(r.progress, 10)}</Text>{"  "}
               <Text color="blue">{padLeft(r.compiled, 8)}</Text>{"  "}
               <Text color="green">{padLeft(r.correct, 7)}</Text>{"  "}
-              <Text color="magenta">{padLeft(r.speedup, 11)}</Text>
+              <Text color="red">{padLeft(r.infra, 5)}</Text>{"  "}
+              <Text color="magenta">{padLeft(r.speedup, 11)}</Text>{"  "}
+              <Text color="yellow">{padLeft(r.cost, 8)}</Text>
             </Text>
           ))}
         </Box>
@@ -380,7 +236,7 @@ const App: React.FC = () => {
 
         {stage === "done" && (
           <Box marginTop={1}>
-            <Text color="green">Done! Results saved to ./results/{suite?.id}/{version}/</Text>
+            <Text color="green">Done! Results saved to {outputDir || `./results/${suite?.id}/${version}`}/</Text>
           </Box>
         )}
       </Box>
@@ -0,0 +1,57 @@
+#!/usr/bin/env bun
+// headless benchmark run for ci and batch jobs
+//   bun run optim:headless --suite <id> [--version <label>] [--models free,google,<name>]
+//     [--tests a,b] [--variants a,b] [--samples N | a-b] [--replay <version>] [--reuse-generations] [--resume] [--dry-run]
+// prints one json event per line on stdout; generated code stays out of the
+// stream, it is in the results log. exits 1 on error
+
+import { join, dirname } from "path";
+import { fileURLToPath } from "url";
+import { findOptimSuites, parseRunArgs, runSession, type RunEvent } from "./run-session";
+
+const benchRoot = dirname(fileURLToPath(import.meta.url));
+
+function line(event: Record<string, unknown>) {
+  process.stdout.write(JSON.stringify({ time: new Date().toISOString(), ...event }) + "\n");
+}
+
+// results carry the full generated source; the stream only needs the scores
+function compact(event: RunEvent): Record<string, unknown> {
+  if (event.type === "result") {
+    const { result: r, ...rest } = event;
+    return {
+      ...rest,
+      compiled: r.compiled,
+      correct: r.correct,
+      speedup: r.speedup,
+      belowNoiseFloor: r.belowNoiseFloor,
+      rooflinePercent: r.optimizedRoofline?.percent,
+      infraError: r.infraError,
+      compileError: r.compileError?.slice(0, 500),
+      costUsd: r.costUsd,
+    };
+  }
+  if (event.type === "done") {
+    const { summary: _summary, ...rest } = event;
+    return rest;
+  }
+  return event;
+}
+
+async function main() {
+  const options = parseRunArgs(process.argv.slice(2));
+  if (!options.suiteId) throw new Error("--suite <id> is required");
+
+  const suites = await findOptimSuites(join(benchRoot, "tests"));
+  const entry = suites.find((s) => s.suite.id === options.suiteId);
+  if (!entry) {
+    throw new Error(`Unknown suite ${options.suiteId} (have ${suites.map((s) => s.suite.id).join(", ")})`);
+  }
+
+  await runSession(options, entry.suite, (event) => line(compact(event)));
+}
+
+main().catch((e) => {
+  line({ type: "error", message: (e as Error).message });
+  process.exit(1);
+});
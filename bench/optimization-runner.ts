@@ -1,28 +1,115 @@
 // optimization benchmark runner
 // compiles and benchmarks AI-optimized code against baseline
 
-import { generateText } from "ai";
-import { writeFile, readFile, mkdir, rm } from "fs/promises";
-import { existsSync } from "fs";
-import { join } from "path";
-import { spawn } from "child_process";
-import type { RunnableModel } from "./constants";
+import { generateText, type ModelMessage } from "ai";
+import { createHash } from "crypto";
+import { rm } from "fs/promises";
+import {
+  CACHE_DIRECTORY,
+  CALIBRATION_CONFIG,
+  CODEGEN_CONFIG,
+  FOOTPRINT_CONFIG,
+  ORACLE_CONFIG,
+  PERF_CONFIG,
+  RATE_LIMIT_CONFIG,
+  REFINE_CONFIG,
+  SAMPLING_CONFIG,
+  SANDBOX_CONFIG,
+  SCHEDULER_CONFIG,
+  TOOLCHAINS,
+  type RunnableModel,
+} from "./constants";
+import { codegenReport, type CodegenReport } from "./asm-report";
+import { belowNoiseFloor, calibrate } from "./calibration";
+import { requestCostUsd } from "./cost";
+import { baselineCacheKey, getOrCreateBaseline, type BaselineEntry } from "./baseline-cache";
+import {
+  generationKey,
+  getOrCreateGeneration,
+  languageModelId,
+  modelKeyParts,
+  readGeneration,
+  type GenerationEntry,
+} from "./generation-cache";
+import {
+  generateHarnessDriver,
+  harnessIterations,
+  parseHarnessSamples,
+  parseHarnessWork,
+  type HarnessSpec,
+} from "./harness";
+import {
+  sampleAdaptive,
+  speedupInterval,
+  summarize,
+  type SampleStats,
+  type SamplingConfig,
+} from "./sampling";
+import { getTimedScheduler } from "./scheduler";
+import { perfRecordCommand, perfStatCommand, type Hotspot, type PerfCounters } from "./perf-counters";
+import { bestRound, feedbackMessage, refineRound, type Refinement, type RefineRound } from "./refinement";
+import {
+  addUsage,
+  needsProfile,
+  renderTemplate,
+  templateVars,
+  tokenUsage,
+  type PromptVariant,
+  type TokenUsage,
+} from "./prompt-variant";
+import type { ResourceUsage } from "./sandbox";
+import { threadCounts, threadEnv, type ThreadPoint, type ThreadScaling, type ThreadSpec } from "./threads";
+import {
+  describeMismatch,
+  generateOracleDriver,
+  oracleFlags,
+  oracleSeeds,
+  outputsMatch,
+  type OracleReport,
+  type OracleSpec,
+  type Tolerance,
+} from "./oracle";
+import { runCommand, type CommandResult } from "./command";
+import { providerKey, withRateLimit } from "./rate-limit";
+import { availableToolchains, forLanguage, sourceFileName, type Language, type Toolchain } from "./toolchain";
+import { buildKey, farmBuild } from "./compile-farm";
+import { footprintVerdict, measureFootprint, type Footprint } from "./footprint";
+import { rooflineScore, type HarnessWork, type Roofline } from "./roofline";
+import {
+  fitScalingExponent,
+  looksConstantTime,
+  sweepFlags,
+  sweepInput,
+  type ParamSweep,
+  type ScalingResult,
+  type SweepPoint,
+} from "./scaling";
 
 export type OptimizationTest = {
   id: string;
   name: string;
   description: string;
-  code: string; // unoptimized C code
-  benchmarkIterations: number; // how many times to run for timing
+  code: string; // unoptimized source, in `language`
+  language?: Language; // default "c"; "cpp" builds with g++ / clang++ -std=c++20
+  benchmarkIterations: number; // minimum timed runs (sampling may add more)
   expectedOutput?: string; // for correctness check (optional)
-  compilerFlags?: string[]; // e.g. ["-O0"] for baseline
+  compilerFlags?: string[]; // extra flags for every baseline and candidate build
+  harness?: HarnessSpec; // time only this kernel in-process instead of the whole program
+  sweep?: ParamSweep; // also time baseline and candidate across these sizes
+  oracle?: OracleSpec; // differential checks against the baseline beyond the fixed input
+  input?: string; // stdin for every run, so sizes aren't compile-time constants
+  threads?: ThreadSpec; // parallel track: also time the candidate at several thread counts
 };
 
+export type TimingMode = "process" | "harness";
+
 export type OptimizationSuite = {
   id: string;
   name: string;
   description: string;
   systemPrompt: string;
+  language?: Language; // default for tests that don't set their own
+  promptVariants?: PromptVariant[]; // every job runs once per variant, see prompt-variant.ts
   tests: OptimizationTest[];
 };
 
@@ -30,6 +117,8 @@ export type OptimizationResult = {
   model: string;
   testId: string;
   testName: string;
+  sample?: number; // TestJob.sample
+  variant?: string; // TestJob.variant id
 
   // compilation
   compiled: boolean;
@@ -40,102 +129,246 @@ export type OptimizationResult = {
   actualOutput?: string;
   expectedOutput?: string;
 
-  // performance
+  // performance (for the primary toolchain, see `toolchains` for the rest)
   baselineTimeMs: number;
   optimizedTimeMs: number;
   speedup: number; // baseline / optimized (>1 means faster)
+  speedupCI?: [number, number]; // 95% bootstrap CI on the speedup
+  timingMode?: TimingMode;
+  baselineSamplesMs?: number[]; // raw per-run (process) or per-iteration (harness) times
+  optimizedSamplesMs?: number[];
+  baselineStats?: SampleStats;
+  optimizedStats?: SampleStats;
+  baselineCounters?: PerfCounters; // from one extra perf stat run, when enabled
+  optimizedCounters?: PerfCounters;
+  baselineResources?: ResourceUsage; // peak rss, faults and context switches of one run
+  optimizedResources?: ResourceUsage;
+  baselineBandwidthGBs?: number; // harness bytes per call / median kernel time
+  optimizedBandwidthGBs?: number;
+  baselineRoofline?: Roofline; // declared work against the calibrated host peaks, see roofline.ts
+  optimizedRoofline?: Roofline;
+  belowNoiseFloor?: boolean; // speedup within the run's calibrated noise, see calibration.ts
+  worker?: { hostname: string; fingerprint: string }; // measured by this worker agent, see worker-pool.ts
+  baselineFootprint?: Footprint; // compile time, section sizes, time-to-main (primary toolchain)
+  optimizedFootprint?: Footprint;
+  footprintPenalty?: number; // multiplies the ranked speedup, see footprint.ts
+  footprintCap?: string; // the cap the candidate exceeded; ranks as a failure
+  oracle?: OracleReport; // differential check, a mismatch makes the result incorrect
+  suspectConstantTime?: boolean; // candidate time flat across the sweep, see scaling.constantTime
+  threadScaling?: ThreadScaling; // parallel track: time and strong-scaling efficiency per thread count
+  toolchain?: string; // id of the primary toolchain
+  toolchains?: ToolchainResult[]; // one per configured toolchain, same-config speedups
+  scaling?: ScalingResult; // time vs size with the primary toolchain, for tests with a sweep
+  codegen?: { baseline?: CodegenReport; optimized?: CodegenReport }; // -S and loop remarks, primary toolchain
 
   // meta
   optimizedCode?: string;
   duration: number; // time to get response from model
   tokensUsed: number;
+  usage?: TokenUsage; // input / output / reasoning split of tokensUsed
+  costUsd?: number; // of the model request(s), when the provider bills or the model has pricing
+  generationKey?: string; // entry in the generation store, what --replay re-measures
+  generationCached?: boolean; // response came from the store, duration and tokens are the original request's
+  duplicateOf?: string; // "<model>#<sample>" whose identical code was measured; every other field is copied from it
+  refinement?: Refinement; // per-round trajectory when feedback rounds ran; the result is the best round
+  infraError?: string; // the request never produced an answer (rate limit, provider, network, timeout); not held against the model
 };
 
-async function runCommand(
-  cmd: string,
-  args: string[],
-  options?: { timeout?: number; input?: string }
-): Promise<{ stdout: string; stderr: string; exitCode: number }> {
-  return new Promise((resolve) => {
-    const proc = spawn(cmd, args, {
-      timeout: options?.timeout ?? 30000,
-    });
-
-    let stdout = "";
-    let stderr = "";
+// a candidate measured against the baseline built with the same toolchain
+export type ToolchainResult = {
+  toolchain: string;
+  compiled: boolean;
+  compileError?: string;
+  correct: boolean;
+  actualOutput?: string;
+  baselineTimeMs: number;
+  optimizedTimeMs: number;
+  speedup: number;
+  speedupCI?: [number, number];
+  baselineSamplesMs?: number[];
+  optimizedSamplesMs?: number[];
+  baselineStats?: SampleStats;
+  optimizedStats?: SampleStats;
+  baselineCounters?: PerfCounters;
+  optimizedCounters?: PerfCounters;
+  baselineResources?: ResourceUsage;
+  optimizedResources?: ResourceUsage;
+  baselineBandwidthGBs?: number;
+  optimizedBandwidthGBs?: number;
+  baselineRoofline?: Roofline;
+  optimizedRoofline?: Roofline;
+  belowNoiseFloor?: boolean;
+  oracle?: OracleReport;
+};
 
-    proc.stdout.on("data", (data) => (stdout += data.toString()));
-    proc.stderr.on("data", (data) => (stderr += data.toString()));
+type BenchmarkRun = {
+  timeMs: number; // median sample
+  output: string;
+  samplesMs: number[];
+  stats: SampleStats;
+  counters?: PerfCounters;
+  resources?: ResourceUsage; // from the run that produced `output`
+  // work per kernel call, when the harness spec declares it
+  bytes?: number;
+  flops?: number;
+  ops?: number;
+  error?: string;
+};
 
-    if (options?.input) {
-      proc.stdin.write(options.input);
-      proc.stdin.end();
-    }
+// how a binary is fed and laid out: stdin, and for the parallel track the
+// thread count (that many exclusive timing cores, OMP_NUM_THREADS)
+type RunSetup = { input?: string; threads?: number };
 
-    proc.on("close", (code) => {
-      resolve({ stdout, stderr, exitCode: code ?? -1 });
-    });
+const runEnv = (setup: RunSetup) => (setup.threads ? threadEnv(setup.threads) : undefined);
 
-    proc.on("error", (err) => {
-      resolve({ stdout, stderr: err.message, exitCode: -1 });
-    });
+// one extra run under perf stat on the same cores the samples came from
+async function collectCounters(
+  executable: string,
+  cpus: number[] | null,
+  setup: RunSetup
+): Promise<PerfCounters | undefined> {
+  // binaries are shared through the compile farm, so the csv name must be unique
+  const csv = `${executable}.${process.pid}-${Math.random().toString(36).slice(2)}.perf.csv`;
+  const perf = perfStatCommand(PERF_CONFIG, executable, [], csv);
+  if (!perf) return undefined;
+  const run = await runCommand(perf.cmd, perf.args, {
+    timeout: 120000,
+    cpus,
+    input: setup.input,
+    env: runEnv(setup),
+    sandbox: SANDBOX_CONFIG,
   });
+  if (run.exitCode !== 0) return undefined;
+  return perf.read();
 }
 
-async function compileC(
-  sourceFile: string,
-  outputFile: string,
-  flags: string[] = []
-): Promise<{ success: boolean; error?: string }> {
-  const result = await runCommand("gcc", [
-    ...flags,
-    "-o",
-    outputFile,
-    sourceFile,
-    "-lm", // link math library
-  ]);
-
-  if (result.exitCode !== 0) {
-    return { success: false, error: result.stderr };
-  }
-  return { success: true };
+function failedRun(error: string): BenchmarkRun {
+  return { timeMs: 0, output: "", samplesMs: [], stats: summarize([]), error };
 }
 
 async function runBenchmark(
   executable: string,
-  iterations: number
-): Promise<{ timeMs: number; output: string; error?: string }> {
-  const times: number[] = [];
-  let output = "";
-
-  for (let i = 0; i < iterations; i++) {
-    const start = performance.now();
-    const result = await runCommand(executable, [], { timeout: 60000 });
-    const elapsed = performance.now() - start;
-
-    if (result.exitCode !== 0) {
-      return { timeMs: 0, output: "", error: result.stderr || "Runtime error" };
-    }
+  minSamples: number,
+  sampling: SamplingConfig,
+  setup: RunSetup
+): Promise<BenchmarkRun> {
+  let output: string | null = null;
+  let resources: ResourceUsage | undefined;
+
+  const sampled = await getTimedScheduler(SCHEDULER_CONFIG).runTimedMany(setup.threads ?? 1, async (cpus) => {
+    const run = await sampleAdaptive(
+      async () => {
+        const start = performance.now();
+        const result = await runCommand(executable, [], {
+          timeout: 60000,
+          cpus,
+          input: setup.input,
+          env: runEnv(setup),
+          sandbox: SANDBOX_CONFIG,
+        });
+        // the sandbox times the child itself, leaving out its own fork, rlimits
+        // and namespace setup; the outer clock is for unsandboxed runs
+        const elapsed = result.usage?.wallMs ?? performance.now() - start;
 
-    times.push(elapsed);
-    if (i === 0) output = result.stdout.trim();
+        if (result.exitCode !== 0) {
+          return { samples: [], error: result.stderr || "Runtime error" };
+        }
+        if (output === null) {
+          output = result.stdout.trim();
+          resources = result.usage;
+        }
+        return { samples: [elapsed] };
+      },
+      { ...sampling, minSamples }
+    );
+    return { ...run, counters: run.error ? undefined : await collectCounters(executable, cpus, setup) };
+  });
+  if (sampled.error) return failedRun(sampled.error);
+
+  return {
+    timeMs: sampled.stats.median,
+    output: output ?? "",
+    samplesMs: sampled.samples,
+    stats: sampled.stats,
+    counters: sampled.counters,
+    resources,
+  };
+}
+
+// runs the program once for its output, then times only the kernel through
+// a generated driver built with the same flags
+async function runHarnessBenchmark(
+  executable: string,
+  sourceFile: string,
+  spec: HarnessSpec,
+  toolchain: Toolchain,
+  extraFlags: string[],
+  sampling: SamplingConfig,
+  setup: RunSetup
+): Promise<BenchmarkRun> {
+  const programRun = await runCommand(executable, [], {
+    timeout: 60000,
+    input: setup.input,
+    env: runEnv(setup),
+    sandbox: SANDBOX_CONFIG,
+  });
+  if (programRun.exitCode !== 0) {
+    return failedRun(programRun.stderr || "Runtime error");
+  }
+
+  // the driver includes the content-addressed source, so it is reused too
+  const driverCompile = await farmBuild(toolchain, generateHarnessDriver(sourceFile, spec), extraFlags, setup.input);
+  const driverBinary = driverCompile.binary;
+  if (!driverCompile.success) {
+    return failedRun(
+      `Harness build failed (is \`${spec.kernel}\` still defined with its original signature?): ${driverCompile.error}`
+    );
   }
 
-  // use median time
-  times.sort((a, b) => a - b);
-  const median = times[Math.floor(times.length / 2)];
+  // the driver warms up on its own, so every invocation is one batch of samples
+  let work: HarnessWork | undefined;
+  const sampled = await getTimedScheduler(SCHEDULER_CONFIG).runTimedMany(setup.threads ?? 1, async (cpus) => {
+    const run = await sampleAdaptive(
+      async () => {
+        const driverRun = await runCommand(driverBinary, [], {
+          timeout: 120000,
+          cpus,
+          input: setup.input,
+          env: runEnv(setup),
+          sandbox: SANDBOX_CONFIG,
+        });
+        if (driverRun.exitCode !== 0) {
+          return { samples: [], error: driverRun.stderr || "Harness runtime error" };
+        }
+        work ??= parseHarnessWork(driverRun.stdout);
+        return { samples: parseHarnessSamples(driverRun.stdout) };
+      },
+      { ...sampling, warmupRuns: 0, minSamples: harnessIterations(spec).iterations }
+    );
+    // counts cover the driver's setup too, the kernel dominates for these sizes
+    return { ...run, counters: run.error ? undefined : await collectCounters(driverBinary, cpus, setup) };
+  });
+  if (sampled.error) return failedRun(sampled.error);
 
-  return { timeMs: median, output };
+  return {
+    timeMs: sampled.stats.median,
+    output: programRun.stdout.trim(),
+    samplesMs: sampled.samples,
+    stats: sampled.stats,
+    counters: sampled.counters,
+    resources: programRun.usage,
+    ...work,
+  };
 }
 
 function extractCodeFromResponse(response: string): string | null {
-  // try to find code block
-  const codeBlockMatch = response.match(/```(?:c|cpp)?\s*([\s\S]*?)```/);
+  // try to find code block; longest language tag first so "cpp" isn't read as "c"
+  const codeBlockMatch = response.match(/```(?:c\+\+|cpp|cxx|cc|c)?[ \t]*\n?([\s\S]*?)```/);
   if (codeBlockMatch) {
     return codeBlockMatch[1].trim();
   }
 
-  // if no code block, check if response looks like C code
+  // if no code block, check if response looks like C / C++ code
   if (response.includes("#include") || response.includes("int main")) {
     return response.trim();
   }
@@ -143,201 +376,930 @@ function extractCodeFromResponse(response: string): string | null {
   return null;
 }
 
-export async function runOptimizationTest(options: {
+export type TestJob = {
   model: RunnableModel;
   test: OptimizationTest;
   systemPrompt: string;
-  workDir: string;
+  cacheDir?: string; // baseline and generation store, defaults to results/cache
+  timingMode?: TimingMode; // "harness" (default) applies only to tests that declare one
+  sampling?: SamplingConfig; // defaults to SAMPLING_CONFIG
+  toolchains?: Toolchain[]; // defaults to the installed subset of TOOLCHAINS
+  timeoutMs?: number; // deadline for the model request
+  sweep?: boolean; // run the test's size sweep if it has one (default true)
+  sample?: number; // index among repeated requests for the same (model, test), default 0
+  variant?: PromptVariant; // templated prompt changes, the suite's prompt otherwise
+  replay?: string; // generation key to re-measure; never calls the model
+  reuseGenerations?: boolean; // answer from the generation store when it holds this exact request (default: ask the model)
+  refineRounds?: number; // feedback rounds after the first answer, defaults to REFINE_CONFIG.rounds
   silent?: boolean;
-}): Promise<OptimizationResult> {
-  const { model, test, systemPrompt, workDir, silent } = options;
-  const startTime = performance.now();
+};
 
-  // ensure work directory exists
-  if (!existsSync(workDir)) {
-    await mkdir(workDir, { recursive: true });
-  }
+type BaselineOutcome = { entry: BaselineEntry | null; error?: string };
+
+// the candidate built with one toolchain
+export type ToolchainBuild = {
+  toolchain: Toolchain;
+  source: string; // content-addressed copy in the compile farm
+  binary: string;
+  compiled: boolean;
+  compileMs?: number;
+  error?: string; // compile or runtime error, the build is skipped from then on
+  output?: string;
+  correct?: boolean;
+  oracle?: OracleReport;
+};
+
+// one (model, test) job as it moves through the stages; `result` is set as
+// soon as it is finished, successfully or not
+export type Candidate = {
+  job: TestJob;
+  timingMode: TimingMode;
+  sampling: SamplingConfig;
+  toolchains: Toolchain[]; // first one is primary
+  baselines: Map<string, Promise<BaselineOutcome>>; // by toolchain id
+  tokensUsed: number;
+  usage?: TokenUsage;
+  costUsd?: number;
+  generationMs: number;
+  generationKey?: string;
+  generationCached?: boolean;
+  response?: string;
+  code?: string;
+  measured?: MeasuredCode; // first candidate with this code, settles it when done
+  original?: Promise<OptimizationResult>; // a copy of earlier code, skips compile/verify/measure
+  round: number; // refinement round, 0 = the first answer
+  messages: ModelMessage[]; // earlier rounds and their feedback, empty on round 0
+  rounds: Array<{ result: OptimizationResult; trace: RefineRound }>; // finished earlier rounds
+  hotspots?: Hotspot[]; // profile of this round's candidate, for the next round's feedback
+  stopRefining?: boolean; // nothing another round could fix (no toolchain, the request failed)
 
-  const baselineSource = join(workDir, `${test.id}_baseline.c`);
-  const baselineBinary = join(workDir, `${test.id}_baseline`);
-  const optimizedSource = join(workDir, `${test.id}_optimized.c`);
-  const optimizedBinary = join(workDir, `${test.id}_optimized`);
-
-  // write and compile baseline
-  await writeFile(baselineSource, test.code);
-  const baselineCompile = await compileC(
-    baselineSource,
-    baselineBinary,
-    test.compilerFlags ?? ["-O0"]
+  builds: ToolchainBuild[];
+  result?: OptimizationResult;
+};
+
+export type StageName = "generate" | "extract" | "compile" | "verify" | "measure";
+
+function measureProgram(
+  c: Candidate,
+  toolchain: Toolchain,
+  executable: string,
+  sourceFile: string,
+  extraFlags: string[],
+  setup: RunSetup
+): Promise<BenchmarkRun> {
+  const { test } = c.job;
+  // parallel-track tests run single-threaded unless a thread count is asked for
+  const run = { ...setup, threads: setup.threads ?? (test.threads ? 1 : undefined) };
+  return c.timingMode === "harness"
+    ? runHarnessBenchmark(executable, sourceFile, test.harness!, toolchain, extraFlags, c.sampling, run)
+    : runBenchmark(executable, test.benchmarkIterations, c.sampling, run);
+}
+
+// compile and time baseline with one toolchain (or reuse a cached run)
+async function prepareBaseline(
+  c: Candidate,
+  toolchain: Toolchain,
+  extraFlags: string[] = c.job.test.compilerFlags ?? [],
+  input: string | undefined = c.job.test.input
+): Promise<BaselineOutcome> {
+  const { test, cacheDir } = c.job;
+  let baselineError: string | undefined;
+
+  const entry = await getOrCreateBaseline(
+    cacheDir ?? CACHE_DIRECTORY,
+    baselineCacheKey({
+      code: test.code,
+      compiler: toolchain.compiler,
+      flags: [...toolchain.flags, ...extraFlags, ...(toolchain.pgo ? ["+pgo"] : [])],
+      iterations: test.benchmarkIterations,
+      timing: {
+        mode: c.timingMode,
+        harness: test.harness ?? null,
+        input: input ?? null,
+        sampling: c.sampling,
+        perf: PERF_CONFIG.enabled,
+        sandbox: SANDBOX_CONFIG,
+      },
+    }),
+    async () => {
+      const baselineCompile = await farmBuild(toolchain, test.code, extraFlags, input);
+      if (!baselineCompile.success) {
+        baselineError = `Baseline failed to compile with ${toolchain.id}: ${baselineCompile.error}`;
+        return null;
+      }
+
+      const run = await measureProgram(
+        c,
+        toolchain,
+        baselineCompile.binary,
+        baselineCompile.source,
+        extraFlags,
+        { input }
+      );
+      if (run.error) {
+        baselineError = `Baseline runtime error with ${toolchain.id}: ${run.error}`;
+        return null;
+      }
+
+      return {
+        testId: test.id,
+        compiler: toolchain.compiler,
+        flags: [...toolchain.flags, ...extraFlags],
+        iterations: test.benchmarkIterations,
+        timingMode: c.timingMode,
+        timeMs: run.timeMs,
+        samplesMs: run.samplesMs,
+        stats: run.stats,
+        counters: run.counters,
+        resources: run.resources,
+        bytes: run.bytes,
+        flops: run.flops,
+        ops: run.ops,
+        output: run.output,
+      };
+    }
   );
 
-  if (!baselineCompile.success) {
-    return {
-      model: model.name,
-      testId: test.id,
-      testName: test.name,
-      compiled: false,
-      compileError: `Baseline failed to compile: ${baselineCompile.error}`,
-      correct: false,
-      baselineTimeMs: 0,
-      optimizedTimeMs: 0,
-      speedup: 0,
-      duration: performance.now() - startTime,
-      tokensUsed: 0,
-    };
+  return { entry, error: entry ? undefined : baselineError ?? "Baseline failed in another run" };
+}
+
+const sweepBaselineId = (tc: Toolchain, sweep: ParamSweep, value: number) =>
+  `${tc.id}:${sweep.define}=${value}`;
+
+const sweepEnabled = (c: Candidate) => !!c.job.test.sweep && c.job.sweep !== false;
+
+// the configured (and installed) toolchains, as their c++ drivers for c++ tests.
+// a coordinator can't tell what its workers have installed
+function testToolchains(job: TestJob, remote: boolean): Toolchain[] {
+  const language = job.test.language;
+  if (job.toolchains) return job.toolchains.map((tc) => forLanguage(tc, language));
+  const configured = TOOLCHAINS.map((tc) => forLanguage(tc, language));
+  return remote ? configured : availableToolchains(configured);
+}
+
+// baselines start building right away; they are only awaited at verify time.
+// a remote candidate is only generated here, its worker builds the baselines
+export function createCandidate(job: TestJob, remote = false): Candidate {
+  const c: Candidate = {
+    job,
+    timingMode: job.timingMode !== "process" && job.test.harness ? "harness" : "process",
+    sampling: job.sampling ?? SAMPLING_CONFIG,
+    toolchains: testToolchains(job, remote),
+    baselines: new Map(),
+    tokensUsed: 0,
+    generationMs: 0,
+    builds: [],
+    round: 0,
+    messages: [],
+    rounds: [],
+  };
+  if (remote) return c;
+  for (const tc of c.toolchains) {
+    c.baselines.set(
+      tc.id,
+      prepareBaseline(c, tc).catch((err) => ({ entry: null, error: `Baseline failed: ${err}` }))
+    );
   }
 
-  // run baseline benchmark
-  const baselineRun = await runBenchmark(baselineBinary, test.benchmarkIterations);
-  if (baselineRun.error) {
-    return {
-      model: model.name,
-      testId: test.id,
-      testName: test.name,
-      compiled: false,
-      compileError: `Baseline runtime error: ${baselineRun.error}`,
-      correct: false,
-      baselineTimeMs: 0,
-      optimizedTimeMs: 0,
-      speedup: 0,
-      duration: performance.now() - startTime,
-      tokensUsed: 0,
-    };
+  // size sweeps only run with the primary toolchain
+  const sweep = job.test.sweep;
+  const primary = c.toolchains[0];
+  if (sweep && primary && sweepEnabled(c)) {
+    for (const value of sweep.values) {
+      const flags = [...(job.test.compilerFlags ?? []), ...sweepFlags(sweep, value)];
+      c.baselines.set(
+        sweepBaselineId(primary, sweep, value),
+        prepareBaseline(c, primary, flags, sweepInput(sweep, value) ?? job.test.input).catch((err) => ({ entry: null, error: `Baseline failed: ${err}` }))
+      );
+    }
+  }
+  return c;
+}
+
+// per-toolchain outcome for builds that never got measured
+function unmeasured(build: ToolchainBuild): ToolchainResult {
+  return {
+    toolchain: build.toolchain.id,
+    compiled: build.compiled,
+    compileError: build.error,
+    correct: false,
+    actualOutput: build.output,
+    baselineTimeMs: 0,
+    optimizedTimeMs: 0,
+    speedup: 0,
+    oracle: build.oracle,
+  };
+}
+
+// marks a candidate as finished with a failed (or partial) result
+export function failCandidate(c: Candidate, fields: Partial<OptimizationResult>): Candidate {
+  c.result = {
+    model: c.job.model.name,
+    testId: c.job.test.id,
+    testName: c.job.test.name,
+    sample: c.job.sample ?? 0,
+    variant: c.job.variant?.id,
+    compiled: false,
+    correct: false,
+    baselineTimeMs: 0,
+    optimizedTimeMs: 0,
+    speedup: 0,
+    toolchain: c.toolchains[0]?.id,
+    toolchains: c.builds.length > 0 ? c.builds.map(unmeasured) : undefined,
+    optimizedCode: c.code,
+    duration: c.generationMs,
+    tokensUsed: c.tokensUsed,
+    usage: c.usage,
+    costUsd: c.costUsd,
+    generationKey: c.generationKey,
+    generationCached: c.generationCached,
+    ...fields,
+  };
+  return c;
+}
+
+// get optimization from model
+async function generateStage(c: Candidate): Promise<Candidate> {
+  const { model, test, variant, timeoutMs } = c.job;
+  if (c.toolchains.length === 0) {
+    c.stopRefining = true;
+    return failCandidate(c, { compileError: "No configured toolchain is installed" });
   }
 
-  // get optimization from model
-  const prompt = `Optimize this C code for maximum performance. Return ONLY the optimized code, no explanations.
+  // a variant that quotes the baseline profile has to wait for it
+  const primary = c.toolchains[0];
+  const profiled = needsProfile(variant) ? (await c.baselines.get(primary.id))?.entry : null;
+  const vars = templateVars(test, primary, profiled);
+  const systemPrompt = variant?.system ? renderTemplate(variant.system, vars) : c.job.systemPrompt;
+  const prefixRule = variant?.prefix ? `${renderTemplate(variant.prefix, vars)}\n\n` : "";
+  const variantRule = variant?.suffix ? `\n\n${renderTemplate(variant.suffix, vars)}` : "";
 
-\`\`\`c
+  // the harness and the oracle driver call the kernel and size macros directly
+  const kernelRule =
+    test.harness && (c.timingMode === "harness" || test.oracle?.driver)
+      ? `\n\nKeep the function \`${test.harness.kernel}\` with its exact signature; it is timed and checked directly.`
+      : "";
+  const guarded = [
+    ...new Set([
+      ...(sweepEnabled(c) ? [test.sweep!.define] : []),
+      ...(ORACLE_CONFIG.enabled && test.oracle?.define ? [test.oracle.define] : []),
+    ]),
+  ];
+  const sizeRule =
+    guarded.length > 0
+      ? `\n\nKeep the ${guarded.map((d) => `\`#ifndef ${d}\``).join(", ")} guard${guarded.length > 1 ? "s" : ""}; sizes are also set with -D at compile time.`
+      : "";
+  const threadRule = test.threads
+    ? "\n\nYou may use OpenMP or pthreads. The program is run with OMP_NUM_THREADS set and pinned to that many cores; size any thread pool from it."
+    : "";
+  const inputRule = test.input
+    ? "\n\nThe program reads its problem size from stdin and is run with different sizes; keep reading it the same way."
+    : "";
+  const cpp = test.language === "cpp";
+  const prompt = `${prefixRule}Optimize this ${cpp ? "C++20" : "C"} code for maximum performance. Return ONLY the optimized code, no explanations.${kernelRule}${sizeRule}${inputRule}${threadRule}${variantRule}
+
+\`\`\`${cpp ? "cpp" : "c"}
 ${test.code}
 \`\`\``;
 
-  let optimizedCode: string | null = null;
-  let tokensUsed = 0;
-
-  try {
-    const result = await generateText({
-      model: model.llm,
-      system: systemPrompt,
-      prompt,
-      temperature: 0.3,
-      providerOptions: model.providerOptions,
-    });
+  const cacheDir = c.job.cacheDir ?? CACHE_DIRECTORY;
+  if (c.job.replay) {
+    const entry = await readGeneration(cacheDir, c.job.replay);
+    if (!entry) {
+      return failCandidate(c, { compileError: `Generation ${c.job.replay} is not in the store` });
+    }
+    return useGeneration(c, entry, true);
+  }
 
-    tokensUsed = result.usage?.totalTokens ?? 0;
-    optimizedCode = extractCodeFromResponse(result.text);
+  // refinement rounds continue the conversation: first prompt, then each
+  // answer and the feedback it got
+  const messages: ModelMessage[] | undefined =
+    c.round > 0 ? [{ role: "user", content: prompt }, ...c.messages] : undefined;
+  const temperature = 0.3;
+  const key = generationKey({
+    ...modelKeyParts(model),
+    system: systemPrompt,
+    prompt: messages ? JSON.stringify(messages) : prompt,
+    temperature,
+    sample: c.job.sample ?? 0,
+  });
 
-    if (!optimizedCode) {
+  const start = performance.now();
+  try {
+    const { entry, cached } = await getOrCreateGeneration(cacheDir, key, c.job.reuseGenerations ?? false, async () => {
+      // retries are ours, so they respect the provider's bucket and Retry-After.
+      // only the attempt that answered is timed, not the waits before it
+      let requestStart = start;
+      const result = await withRateLimit(providerKey(model.llm), RATE_LIMIT_CONFIG, timeoutMs, (abortSignal) => {
+        requestStart = performance.now();
+        return generateText({
+          model: model.llm,
+          system: systemPrompt,
+          ...(messages ? { messages } : { prompt }),
+          temperature,
+          providerOptions: model.providerOptions,
+          maxRetries: 0,
+          abortSignal,
+        });
+      });
       return {
         model: model.name,
+        modelId: languageModelId(model.llm),
         testId: test.id,
-        testName: test.name,
-        compiled: false,
-        compileError: "Could not extract code from model response",
-        correct: false,
-        baselineTimeMs: baselineRun.timeMs,
-        optimizedTimeMs: 0,
-        speedup: 0,
-        duration: performance.now() - startTime,
-        tokensUsed,
+        sample: c.job.sample ?? 0,
+        response: result.text,
+        code: extractCodeFromResponse(result.text),
+        tokensUsed: result.usage?.totalTokens ?? 0,
+        usage: result.usage,
+        costUsd: requestCostUsd(result, model.pricing),
+        generationMs: performance.now() - requestStart,
       };
-    }
+    });
+    return useGeneration(c, entry, cached);
   } catch (err) {
-    return {
-      model: model.name,
-      testId: test.id,
-      testName: test.name,
-      compiled: false,
-      compileError: `Model error: ${err}`,
-      correct: false,
-      baselineTimeMs: baselineRun.timeMs,
-      optimizedTimeMs: 0,
-      speedup: 0,
-      duration: performance.now() - startTime,
-      tokensUsed: 0,
-    };
+    c.generationMs = performance.now() - start;
+    c.stopRefining = true;
+    const message = `Model request failed: ${(err as Error).message ?? err}`;
+    return failCandidate(c, { compileError: message, infraError: message });
+  }
+}
+
+function useGeneration(c: Candidate, entry: GenerationEntry, cached: boolean): Candidate {
+  c.generationKey = entry.key;
+  c.generationCached = cached;
+  c.generationMs = entry.generationMs;
+  c.tokensUsed = entry.tokensUsed;
+  c.usage = tokenUsage(entry.usage, entry.tokensUsed);
+  c.costUsd = entry.costUsd;
+  c.response = entry.response;
+  c.code = entry.code ?? undefined;
+  return c;
+}
+
+async function extractStage(c: Candidate): Promise<Candidate> {
+  // stored generations carry their extracted code
+  const code = c.code ?? extractCodeFromResponse(c.response ?? "");
+  if (!code) {
+    return failCandidate(c, { compileError: "Could not extract code from model response" });
   }
+  c.code = code;
+
+  const key = codeKey(c);
+  const first = measuredCode.get(key);
+  if (first) {
+    c.original = first.result;
+  } else {
+    let settle!: (r: OptimizationResult) => void;
+    c.measured = { result: new Promise((resolve) => (settle = resolve)), settle };
+    measuredCode.set(key, c.measured);
+  }
+  return c;
+}
+
+type MeasuredCode = { result: Promise<OptimizationResult>; settle: (r: OptimizationResult) => void };
 
-  // write and compile optimized code
-  await writeFile(optimizedSource, optimizedCode);
-  const optimizedCompile = await compileC(
-    optimizedSource,
-    optimizedBinary,
-    ["-O3", "-march=native"] // let gcc also optimize
+// repeated samples often return byte-identical code; it is measured once per
+// (test, measurement setup) and later copies reuse that result
+const measuredCode = new Map<string, MeasuredCode>();
+
+function codeKey(c: Candidate): string {
+  return createHash("sha256")
+    .update(
+      JSON.stringify({
+        test: c.job.test.id,
+        timingMode: c.timingMode,
+        sampling: c.sampling,
+        toolchains: c.toolchains.map((tc) => tc.id),
+        sweep: sweepEnabled(c),
+        code: c.code,
+      })
+    )
+    .digest("hex");
+}
+
+// call once a candidate has its result so copies of its code can finish
+export function settleCandidate(c: Candidate) {
+  if (c.measured && c.result) c.measured.settle(c.result);
+}
+
+// a copy takes the measured result and keeps its own generation fields
+export async function resolveDuplicate(c: Candidate): Promise<Candidate> {
+  const r = await c.original!;
+  c.result = {
+    ...r,
+    model: c.job.model.name,
+    sample: c.job.sample ?? 0,
+    variant: c.job.variant?.id,
+    duration: c.generationMs,
+    tokensUsed: c.tokensUsed,
+    usage: c.usage,
+    costUsd: c.costUsd,
+    generationKey: c.generationKey,
+    generationCached: c.generationCached,
+    duplicateOf: r.duplicateOf ?? `${r.model}#${r.sample ?? 0}`,
+  };
+  return c;
+}
+
+// build the optimized code with every toolchain through the compile farm;
+// byte-identical responses from earlier jobs are not recompiled
+async function compileStage(c: Candidate): Promise<Candidate> {
+  const { test } = c.job;
+
+  c.builds = await Promise.all(
+    c.toolchains.map(async (tc) => {
+      const build = await farmBuild(tc, c.code!, test.compilerFlags ?? [], test.input);
+      return {
+        toolchain: tc,
+        source: build.source,
+        binary: build.binary,
+        compiled: build.success,
+        compileMs: build.compileMs,
+        error: build.error,
+      };
+    })
   );
 
-  if (!optimizedCompile.success) {
-    return {
-      model: model.name,
-      testId: test.id,
-      testName: test.name,
-      compiled: false,
-      compileError: optimizedCompile.error,
-      correct: false,
-      baselineTimeMs: baselineRun.timeMs,
+  if (!c.builds.some((b) => b.compiled)) {
+    return failCandidate(c, { compileError: c.builds[0].error });
+  }
+  return c;
+}
+
+const testTolerance = (test: OptimizationTest): Tolerance => ({
+  ...ORACLE_CONFIG.tolerance,
+  ...test.oracle?.tolerance,
+});
+
+// oracle binaries are content-addressed, so runs are memoized per process;
+// baseline runs in particular are shared by every candidate of a test
+const oracleRuns = new Map<string, Promise<CommandResult>>();
+
+function oracleRun(binary: string, args: string[]): Promise<CommandResult> {
+  const key = [binary, ...args].join("\0");
+  let run = oracleRuns.get(key);
+  if (!run) {
+    run = runCommand(binary, args, {
+      timeout: 60000,
+      cpus: getTimedScheduler(SCHEDULER_CONFIG).compileCpus,
+      sandbox: SANDBOX_CONFIG,
+    });
+    oracleRuns.set(key, run);
+  }
+  return run;
+}
+
+// rebuild baseline and candidate at every oracle size (and with the random
+// input driver, if the test has one) and compare each run's output
+async function runOracle(c: Candidate, build: ToolchainBuild): Promise<OracleReport | undefined> {
+  const { test } = c.job;
+  const spec = test.oracle;
+  if (!spec || !ORACLE_CONFIG.enabled) return undefined;
+
+  const tolerance = testTolerance(test);
+  const sizes: Array<number | null> = spec.define && spec.sizes?.length ? spec.sizes : [null];
+  const seeds = spec.driver ? oracleSeeds(ORACLE_CONFIG) : [];
+  const report: OracleReport = { checks: 0, sizes: sizes.filter((s) => s !== null), seeds };
+
+  // the whole program at every size guards main(), the driver guards the kernel
+  const variants: Array<{ wrap: (code: string) => string; inputs: Array<number | null> }> = [];
+  if (report.sizes.length > 0) variants.push({ wrap: (code) => code, inputs: [null] });
+  if (spec.driver) variants.push({ wrap: (code) => generateOracleDriver(code, spec.driver!, sourceFileName(build.toolchain)), inputs: seeds });
+
+  for (const size of sizes) {
+    const flags = [...(test.compilerFlags ?? []), ...oracleFlags(spec, size)];
+    const at = size === null ? "" : ` at ${spec.define}=${size}`;
+
+    for (const variant of variants) {
+      const [reference, candidate] = await Promise.all([
+        farmBuild(build.toolchain, variant.wrap(test.code), flags, test.input),
+        farmBuild(build.toolchain, variant.wrap(c.code!), flags, test.input),
+      ]);
+      // a size the baseline itself can't handle says nothing about the candidate
+      if (!reference.success) continue;
+      if (!candidate.success) {
+        return { ...report, mismatch: `Failed to build${at}: ${candidate.error}` };
+      }
+
+      for (const seed of variant.inputs) {
+        const args = seed === null ? [] : [String(seed)];
+        const where = `${at}${seed === null ? "" : ` with seed ${seed}`}`;
+        const [expected, actual] = await Promise.all([
+          oracleRun(reference.binary, args),
+          oracleRun(candidate.binary, args),
+        ]);
+        if (expected.exitCode !== 0) continue;
+
+        report.checks++;
+        if (actual.exitCode !== 0) {
+          return { ...report, mismatch: `Runtime error${where}: ${actual.stderr || "Runtime error"}` };
+        }
+        if (!outputsMatch(actual.stdout, expected.stdout, tolerance)) {
+          return { ...report, mismatch: `Wrong output${where}: ${describeMismatch(actual.stdout, expected.stdout)}` };
+        }
+      }
+    }
+  }
+  return report;
+}
+
+// one untimed run per build to check the output against the expected output,
+// or the output of the baseline built with the same toolchain
+async function verifyStage(c: Candidate): Promise<Candidate> {
+  const { test } = c.job;
+
+  for (const build of c.builds) {
+    if (!build.compiled) continue;
+
+    const baseline = await c.baselines.get(build.toolchain.id)!;
+    if (!baseline.entry) {
+      build.error = baseline.error;
+      continue;
+    }
+
+    const run = await runCommand(build.binary, [], {
+      timeout: 60000,
+      input: test.input,
+      cpus: getTimedScheduler(SCHEDULER_CONFIG).compileCpus,
+      sandbox: SANDBOX_CONFIG,
+    });
+    if (run.exitCode !== 0) {
+      build.error = `Optimized runtime error: ${run.stderr || "Runtime error"}`;
+      continue;
+    }
+
+    // the baseline built with the same toolchain is the reference; a declared
+    // expected output must match as well
+    const tolerance = testTolerance(test);
+    build.output = run.stdout.trim();
+    build.correct =
+      outputsMatch(build.output, baseline.entry.output, tolerance) &&
+      (!test.expectedOutput || outputsMatch(build.output, test.expectedOutput, tolerance));
+
+    if (build.correct) {
+      build.oracle = await runOracle(c, build);
+      if (build.oracle?.mismatch) build.correct = false;
+    }
+  }
+
+  if (!c.builds.some((b) => b.compiled && !b.error)) {
+    const primary = c.builds[0];
+    return failCandidate(c, { compiled: primary.compiled, compileError: primary.error });
+  }
+  return c;
+}
+
+// rebuild the primary candidate at every sweep size and time it against the
+// baseline built with the same -D; correctness is checked per size
+async function measureSweep(c: Candidate, build: ToolchainBuild): Promise<ScalingResult> {
+  const { test } = c.job;
+  const sweep = test.sweep!;
+  const points: SweepPoint[] = [];
+
+  for (const value of sweep.values) {
+    const flags = [...(test.compilerFlags ?? []), ...sweepFlags(sweep, value)];
+    const baseline = (await c.baselines.get(sweepBaselineId(build.toolchain, sweep, value))!).entry;
+    const failed = (error?: string): SweepPoint => ({
+      value,
+      baselineTimeMs: baseline?.timeMs ?? 0,
       optimizedTimeMs: 0,
       speedup: 0,
-      optimizedCode,
-      duration: performance.now() - startTime,
-      tokensUsed,
-    };
+      correct: false,
+      error,
+    });
+    if (!baseline) {
+      points.push(failed(`Baseline failed at ${sweep.define}=${value}`));
+      continue;
+    }
+
+    const binary = await farmBuild(build.toolchain, c.code!, flags, sweepInput(sweep, value) ?? test.input);
+    if (!binary.success) {
+      points.push(failed(`Failed to compile at ${sweep.define}=${value}: ${binary.error}`));
+      continue;
+    }
+    const run = await measureProgram(
+      c,
+      build.toolchain,
+      binary.binary,
+      binary.source,
+      flags,
+      { input: sweepInput(sweep, value) ?? test.input }
+    );
+    if (run.error) {
+      points.push(failed(`Runtime error at ${sweep.define}=${value}: ${run.error}`));
+      continue;
+    }
+
+    points.push({
+      value,
+      baselineTimeMs: baseline.timeMs,
+      optimizedTimeMs: run.timeMs,
+      speedup: run.timeMs > 0 ? baseline.timeMs / run.timeMs : 0,
+      correct: outputsMatch(run.output, baseline.output, testTolerance(test)),
+    });
   }
 
-  // run optimized benchmark
-  const optimizedRun = await runBenchmark(optimizedBinary, test.benchmarkIterations);
-  if (optimizedRun.error) {
-    return {
-      model: model.name,
-      testId: test.id,
-      testName: test.name,
+  return {
+    param: sweep.define,
+    points,
+    baselineExponent: fitScalingExponent(points.map((p) => [p.value, p.baselineTimeMs])),
+    optimizedExponent: fitScalingExponent(
+      points.filter((p) => p.correct).map((p) => [p.value, p.optimizedTimeMs])
+    ),
+    constantTime: looksConstantTime(points),
+  };
+}
+
+// time the primary candidate at every thread count on as many exclusive cores;
+// the single-threaded run from measureStage is the t1 reference
+async function measureThreadScaling(
+  c: Candidate,
+  build: ToolchainBuild,
+  baseline: BaselineEntry,
+  singleThreadMs: number
+): Promise<ThreadScaling> {
+  const { test } = c.job;
+  const tolerance = testTolerance(test);
+  const counts = threadCounts(test.threads!, getTimedScheduler(SCHEDULER_CONFIG).timingCpus.length);
+  const points: ThreadPoint[] = [];
+
+  for (const threads of counts) {
+    const run =
+      threads === 1
+        ? { timeMs: singleThreadMs, output: build.output ?? "", error: undefined }
+        : await measureProgram(c, build.toolchain, build.binary, build.source, test.compilerFlags ?? [], {
+            input: test.input,
+            threads,
+          });
+    points.push({
+      threads,
+      timeMs: run.timeMs,
+      speedup: run.timeMs > 0 ? baseline.timeMs / run.timeMs : 0,
+      efficiency: run.timeMs > 0 ? singleThreadMs / (threads * run.timeMs) : 0,
+      correct: !run.error && outputsMatch(run.output, baseline.output, tolerance),
+      error: run.error,
+    });
+  }
+
+  const last = points[points.length - 1];
+  return {
+    singleThreadSpeedup: singleThreadMs > 0 ? baseline.timeMs / singleThreadMs : 0,
+    points,
+    maxThreads: last?.threads ?? 1,
+    efficiencyAtMax: last?.correct ? last.efficiency : undefined,
+  };
+}
+
+// effective bandwidth: the traffic the kernel needs at minimum, not what it moved
+const bandwidthGBs = (bytes: number | undefined, timeMs: number) =>
+  bytes && timeMs > 0 ? bytes / (timeMs / 1000) / 1e9 : undefined;
+
+// run every working build on an exclusive timing core
+async function measureStage(c: Candidate): Promise<Candidate> {
+  const { model, test, silent } = c.job;
+
+  const calibration = await calibrate(CALIBRATION_CONFIG);
+  const toolchainResults: ToolchainResult[] = [];
+  for (const build of c.builds) {
+    if (!build.compiled || build.error) {
+      toolchainResults.push(unmeasured(build));
+      continue;
+    }
+
+    const baselineRun = (await c.baselines.get(build.toolchain.id)!).entry!;
+    const optimizedRun = await measureProgram(
+      c,
+      build.toolchain,
+      build.binary,
+      build.source,
+      test.compilerFlags ?? [],
+      { input: test.input }
+    );
+    if (optimizedRun.error) {
+      toolchainResults.push({
+        ...unmeasured(build),
+        compileError: `Optimized runtime error: ${optimizedRun.error}`,
+        baselineTimeMs: baselineRun.timeMs,
+      });
+      continue;
+    }
+
+    // calculate speedup against the same-toolchain baseline
+    const speedup =
+      optimizedRun.timeMs > 0 ? baselineRun.timeMs / optimizedRun.timeMs : 0;
+
+    toolchainResults.push({
+      toolchain: build.toolchain.id,
       compiled: true,
-      correct: false,
-      compileError: `Optimized runtime error: ${optimizedRun.error}`,
+      correct: build.correct ?? false,
+      actualOutput: build.output,
       baselineTimeMs: baselineRun.timeMs,
-      optimizedTimeMs: 0,
-      speedup: 0,
-      optimizedCode,
-      duration: performance.now() - startTime,
-      tokensUsed,
-    };
+      optimizedTimeMs: optimizedRun.timeMs,
+      speedup,
+      speedupCI: speedupInterval(baselineRun.samplesMs, optimizedRun.samplesMs),
+      baselineSamplesMs: baselineRun.samplesMs,
+      optimizedSamplesMs: optimizedRun.samplesMs,
+      baselineStats: baselineRun.stats,
+      optimizedStats: optimizedRun.stats,
+      baselineCounters: baselineRun.counters,
+      optimizedCounters: optimizedRun.counters,
+      baselineResources: baselineRun.resources,
+      optimizedResources: optimizedRun.resources,
+      baselineBandwidthGBs: bandwidthGBs(baselineRun.bytes, baselineRun.timeMs),
+      optimizedBandwidthGBs: bandwidthGBs(optimizedRun.bytes, optimizedRun.timeMs),
+      baselineRoofline: rooflineScore(baselineRun, baselineRun.timeMs, calibration?.peaks),
+      optimizedRoofline: rooflineScore(optimizedRun, optimizedRun.timeMs, calibration?.peaks),
+      belowNoiseFloor: calibration
+        ? belowNoiseFloor(calibration, c.timingMode, speedup, optimizedRun.timeMs) || undefined
+        : undefined,
+      oracle: build.oracle,
+    });
   }
 
-  // check correctness
-  const correct =
-    !test.expectedOutput ||
-    optimizedRun.output === test.expectedOutput ||
-    optimizedRun.output === baselineRun.output;
+  const primary = toolchainResults[0];
+  const primaryBaseline = (await c.baselines.get(primary.toolchain)!).entry;
+  const scaling =
+    sweepEnabled(c) && primary.optimizedTimeMs > 0 ? await measureSweep(c, c.builds[0]) : undefined;
+  const threadScaling =
+    test.threads && primaryBaseline && primary.optimizedTimeMs > 0
+      ? await measureThreadScaling(c, c.builds[0], primaryBaseline, primary.optimizedTimeMs)
+      : undefined;
+
+  const footprint = FOOTPRINT_CONFIG.enabled && primary.optimizedTimeMs > 0 ? await measureFootprints(c) : undefined;
+
+  // the next refinement round is told where this one spends its time
+  if (primary.correct && REFINE_CONFIG.profile && refineRoundsLeft(c) > 0) {
+    c.hotspots = await profileHotspots(c, c.builds[0]);
+  }
 
-  // calculate speedup
-  const speedup =
-    optimizedRun.timeMs > 0 ? baselineRun.timeMs / optimizedRun.timeMs : 0;
+  // what the compiler made of both versions, so a speedup can be tied to
+  // vectorization or unrolling
+  const codegen = CODEGEN_CONFIG.enabled
+    ? await Promise.all(
+        [test.code, c.code!].map((code) =>
+          codegenReport(c.builds[0].toolchain, code, test.compilerFlags ?? [], test.harness?.kernel, CODEGEN_CONFIG)
+        )
+      ).then(([baseline, optimized]) => ({ baseline, optimized }))
+    : undefined;
 
   if (!silent) {
     console.log(
-      `${model.name} | ${test.name}: ${speedup.toFixed(2)}x speedup (${baselineRun.timeMs.toFixed(1)}ms -> ${optimizedRun.timeMs.toFixed(1)}ms)`
+      `${model.name} | ${test.name} [${primary.toolchain}]: ${primary.speedup.toFixed(2)}x speedup (${primary.baselineTimeMs.toFixed(1)}ms -> ${primary.optimizedTimeMs.toFixed(1)}ms)`
     );
   }
 
-  return {
+  const { toolchain: _id, ...primaryFields } = primary;
+  c.result = {
     model: model.name,
     testId: test.id,
     testName: test.name,
-    compiled: true,
-    correct,
-    actualOutput: optimizedRun.output,
-    expectedOutput: test.expectedOutput ?? baselineRun.output,
-    baselineTimeMs: baselineRun.timeMs,
-    optimizedTimeMs: optimizedRun.timeMs,
-    speedup,
-    optimizedCode,
-    duration: performance.now() - startTime,
-    tokensUsed,
+    sample: c.job.sample ?? 0,
+    variant: c.job.variant?.id,
+    ...primaryFields,
+    expectedOutput: test.expectedOutput ?? primaryBaseline?.output,
+    timingMode: c.timingMode,
+    toolchain: primary.toolchain,
+    toolchains: toolchainResults,
+    scaling,
+    suspectConstantTime: scaling?.constantTime || undefined,
+    threadScaling,
+    codegen,
+    ...footprint,
+    optimizedCode: c.code,
+    duration: c.generationMs,
+    tokensUsed: c.tokensUsed,
+    usage: c.usage,
+    costUsd: c.costUsd,
+    generationKey: c.generationKey,
+    generationCached: c.generationCached,
   };
+  return c;
 }
 
-// cleanup work directory
-export async function cleanupWorkDir(workDir: string) {
-  if (existsSync(workDir)) {
-    await rm(workDir, { recursive: true, force: true });
+// the baseline's footprint is the same for every job of a test
+const baselineFootprints = new Map<string, Promise<Footprint>>();
+
+async function measureFootprints(c: Candidate): Promise<Partial<OptimizationResult>> {
+  const { test } = c.job;
+  const build = c.builds[0];
+  const flags = test.compilerFlags ?? [];
+  const key = buildKey(build.toolchain, test.code, flags, test.input);
+  let baseline = baselineFootprints.get(key);
+  if (!baseline) {
+    baseline = farmBuild(build.toolchain, test.code, flags, test.input).then((b) =>
+      b.success ? measureFootprint(build.toolchain, test.code, b, flags, FOOTPRINT_CONFIG) : {}
+    );
+    baselineFootprints.set(key, baseline);
+  }
+  const [baselineFootprint, optimizedFootprint] = await Promise.all([
+    baseline,
+    measureFootprint(build.toolchain, c.code!, build, flags, FOOTPRINT_CONFIG),
+  ]);
+  const verdict = footprintVerdict(baselineFootprint, optimizedFootprint, FOOTPRINT_CONFIG);
+  return {
+    baselineFootprint,
+    optimizedFootprint,
+    footprintPenalty: verdict.penalty < 1 ? verdict.penalty : undefined,
+    footprintCap: verdict.cap,
+  };
+}
+
+// one untimed perf record run of the candidate on the non-timing cores
+async function profileHotspots(c: Candidate, build: ToolchainBuild): Promise<Hotspot[]> {
+  const { test } = c.job;
+  const data = `${build.binary}.${process.pid}-${Math.random().toString(36).slice(2)}.perf.data`;
+  const perf = perfRecordCommand(build.binary, [], data);
+  if (!perf) return [];
+  const run = await runCommand(perf.cmd, perf.args, {
+    timeout: 120000,
+    cpus: getTimedScheduler(SCHEDULER_CONFIG).compileCpus,
+    input: test.input,
+    env: runEnv({ threads: test.threads ? 1 : undefined }),
+    sandbox: SANDBOX_CONFIG,
+  });
+  if (run.exitCode !== 0) {
+    await rm(data, { force: true });
+    return [];
+  }
+  return perf.read();
+}
+
+function refineRoundsLeft(c: Candidate): number {
+  // replays re-measure stored answers only
+  const rounds = c.job.replay ? 0 : c.job.refineRounds ?? REFINE_CONFIG.rounds;
+  return c.stopRefining ? 0 : rounds - c.round;
+}
+
+// called once a round has its result: returns the next round, which carries
+// the feedback and reuses this candidate's baselines, or null once done. the
+// final result is the best verified round, with the trajectory and the time
+// and tokens of every round
+export function advanceRound(c: Candidate): Candidate | null {
+  const rounds = [...c.rounds, { result: c.result!, trace: refineRound(c.round, c.result!) }];
+
+  if (refineRoundsLeft(c) > 0) {
+    const feedback = feedbackMessage(c.result!, c.hotspots ?? [], REFINE_CONFIG);
+    return {
+      job: c.job,
+      timingMode: c.timingMode,
+      sampling: c.sampling,
+      toolchains: c.toolchains,
+      baselines: c.baselines,
+      tokensUsed: 0,
+      generationMs: 0,
+      builds: [],
+      round: c.round + 1,
+      messages: [
+        ...c.messages,
+        { role: "assistant", content: c.response ?? "" },
+        { role: "user", content: feedback },
+      ],
+      rounds,
+    };
+  }
+
+  if (rounds.length > 1) {
+    const traces = rounds.map((r) => r.trace);
+    const best = bestRound(traces);
+    // stored rounds cost nothing this time; all-stored keeps the original's numbers
+    const allStored = rounds.every((r) => r.result.generationCached);
+    const fresh = allStored ? rounds : rounds.filter((r) => !r.result.generationCached);
+    c.result = {
+      ...rounds[best].result,
+      duration: fresh.reduce((sum, r) => sum + r.result.duration, 0),
+      tokensUsed: rounds.reduce((sum, r) => sum + r.result.tokensUsed, 0),
+      usage: rounds.reduce<TokenUsage | undefined>((sum, r) => addUsage(sum, r.result.usage), undefined),
+      costUsd: fresh.some((r) => r.result.costUsd !== undefined)
+        ? fresh.reduce((sum, r) => sum + (r.result.costUsd ?? 0), 0)
+        : undefined,
+      generationCached: allStored || undefined,
+      refinement: { rounds: traces, bestRound: best },
+    };
+  }
+  return null;
+}
+
+// stage order; the pipeline runs each with its own concurrency limit
+export const STAGES: Array<{ name: StageName; run: (c: Candidate) => Promise<Candidate> }> = [
+  { name: "generate", run: generateStage },
+  { name: "extract", run: extractStage },
+  { name: "compile", run: compileStage },
+  { name: "verify", run: verifyStage },
+  { name: "measure", run: measureStage },
+];
+
+// runs a single job through every stage in order, once per refinement round
+export async function runOptimizationTest(options: TestJob): Promise<OptimizationResult> {
+  let c = createCandidate(options);
+  for (;;) {
+    for (const stage of STAGES) {
+      c = await stage.run(c);
+      if (c.original) c = await resolveDuplicate(c);
+      if (c.result) break;
+    }
+    settleCandidate(c);
+    const next = advanceRound(c);
+    if (!next) return c.result!;
+    c = next;
   }
 }
@@ -0,0 +1,124 @@
+// differential correctness oracle
+// baseline and candidate are rebuilt at several sizes and, for tests with a
+// kernel, driven with per-seed random inputs; every output has to match the
+// baseline's (numbers within a float tolerance) or the candidate is wrong
+
+import { randomInt } from "crypto";
+
+export type Tolerance = {
+  relative: number;
+  absolute: number;
+};
+
+export type OracleConfig = {
+  enabled: boolean;
+  seeds: number; // random inputs per size for tests with a driver
+  tolerance: Tolerance; // also used for the plain stdout check
+};
+
+export type OracleSpec = {
+  define?: string; // size macro, guarded by #ifndef in the code
+  sizes?: number[]; // rebuild with -D<define>=<size> for each; odd/tiny sizes catch unrolling bugs
+  driver?: {
+    setup: string; // C statements, can use optibench_rand() / optibench_rand_double()
+    check: string; // calls the kernel and prints results with optibench_emit_*()
+  };
+  tolerance?: Partial<Tolerance>; // overrides the config for this test
+};
+
+export type OracleReport = {
+  checks: number; // compared (size, seed) runs
+  sizes: number[];
+  seeds: number[];
+  mismatch?: string; // first difference, set when the candidate failed
+};
+
+let seeds: number[] | null = null;
+
+// drawn once per process so models can't special-case them, shared by every
+// candidate so baseline runs are reused
+export function oracleSeeds(config: OracleConfig): number[] {
+  if (!seeds) seeds = Array.from({ length: config.seeds }, () => randomInt(1, 2 ** 31));
+  return seeds;
+}
+
+export function oracleFlags(spec: OracleSpec, size: number | null): string[] {
+  return spec.define && size !== null ? [`-D${spec.define}=${size}`] : [];
+}
+
+// token-wise comparison; tokens that parse as numbers may differ within the
+// tolerance (vectorized reductions reassociate floating point sums)
+export function outputsMatch(actual: string, expected: string, tolerance: Tolerance): boolean {
+  const a = actual.trim().split(/\s+/);
+  const e = expected.trim().split(/\s+/);
+  if (a.length !== e.length) return false;
+
+  for (let i = 0; i < a.length; i++) {
+    if (a[i] === e[i]) continue;
+    const x = Number(a[i]);
+    const y = Number(e[i]);
+    if (!Number.isFinite(x) || !Number.isFinite(y)) return false;
+    if (Math.abs(x - y) > Math.max(tolerance.absolute, tolerance.relative * Math.abs(y))) return false;
+  }
+  return true;
+}
+
+// short description of where two outputs first differ. it ends up in the
+// refinement feedback, so it names the candidate's value but never the
+// reference's: a model could otherwise print the answer
+export function describeMismatch(actual: string, expected: string): string {
+  const a = actual.trim().split(/\s+/);
+  const e = expected.trim().split(/\s+/);
+  if (a.length !== e.length) return `${a.length} values, expected ${e.length}`;
+  const i = a.findIndex((token, j) => token !== e[j]);
+  return `value ${i} (${a[i]})`;
+}
+
+// the program is inlined rather than included so the driver's compile farm
+// key covers it; sourceName keeps diagnostics pointing at the model's file
+export function generateOracleDriver(
+  code: string,
+  driver: NonNullable<OracleSpec["driver"]>,
+  sourceName = "main.c"
+): string {
+  return `#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define main optibench_program_main
+#line 1 "${sourceName}"
+${code}
+#undef main
+
+static uint64_t optibench_state;
+
+// xorshift64*, seeded from argv[1]
+static uint32_t optibench_rand(void) {
+  optibench_state ^= optibench_state >> 12;
+  optibench_state ^= optibench_state << 25;
+  optibench_state ^= optibench_state >> 27;
+  return (uint32_t)((optibench_state * 2685821657736338717ull) >> 32);
+}
+
+static double optibench_rand_double(void) {
+  return optibench_rand() / 4294967296.0;
+}
+
+static void optibench_emit_long(long long v) { printf("%lld\\n", v); }
+static void optibench_emit_double(double v) { printf("%.17g\\n", v); }
+
+int main(int argc, char **argv) {
+  optibench_state = argc > 1 ? strtoull(argv[1], NULL, 10) * 0x9e3779b97f4a7c15ull + 1 : 1;
+
+  ${driver.setup}
+
+  ${driver.check}
+
+  return 0;
+}
+`;
+}
@@ -0,0 +1,68 @@
+// repeated-sampling metrics
+// with n samples of a (model, test), c of them correct, the unbiased pass@k
+// estimate is 1 - C(n-c, k) / C(n, k); best-of-k is the expected maximum
+// speedup of k samples drawn without replacement (incorrect samples count 0)
+
+export const PASS_AT_K = [1, 5, 10];
+
+export type SampleMetrics = {
+  samples: number;
+  correct: number;
+  passAt: Record<number, number>; // k -> probability at least one of k samples is correct
+  bestOfK: Record<number, number>; // k -> expected best speedup of k samples
+  medianSpeedup: number; // over correct samples
+  speedupIQR?: [number, number]; // 25th / 75th percentile over correct samples
+};
+
+export function passAtK(n: number, c: number, k: number): number {
+  if (n - c < k) return 1;
+  // product form of the binomial ratio, stable for large n
+  let miss = 1;
+  for (let i = n - c + 1; i <= n; i++) miss *= 1 - k / i;
+  return 1 - miss;
+}
+
+// E[max] over k-subsets: the i-th smallest value (1-based) is the max of
+// C(i-1, k-1) of the C(n, k) subsets
+export function bestOfK(values: number[], k: number): number {
+  const sorted = [...values].sort((a, b) => a - b);
+  const n = sorted.length;
+  if (k > n || n === 0) return NaN;
+  // weight of the i-th value is C(i-1, k-1) / C(n, k); at i = k that is 1 / C(n, k)
+  let weight = 1;
+  for (let j = 0; j < k; j++) weight *= (k - j) / (n - j);
+  let expected = 0;
+  for (let i = k; i <= n; i++) {
+    expected += weight * sorted[i - 1];
+    weight *= i / (i - k + 1); // C(i, k-1) / C(i-1, k-1)
+  }
+  return expected;
+}
+
+function quantile(sorted: number[], q: number): number {
+  const pos = (sorted.length - 1) * q;
+  const lo = Math.floor(pos);
+  const hi = Math.ceil(pos);
+  return sorted[lo] + (sorted[hi] - sorted[lo]) * (pos - lo);
+}
+
+// speedups: one per sample, 0 for samples that failed to compile or were wrong
+export function sampleMetrics(speedups: number[]): SampleMetrics {
+  const n = speedups.length;
+  const good = speedups.filter((s) => s > 0).sort((a, b) => a - b);
+  const passAt: Record<number, number> = {};
+  const best: Record<number, number> = {};
+  for (const k of PASS_AT_K) {
+    if (k > n) continue;
+    passAt[k] = passAtK(n, good.length, k);
+    best[k] = bestOfK(speedups, k);
+  }
+  return {
+    samples: n,
+    correct: good.length,
+    passAt,
+    bestOfK: best,
+    medianSpeedup: good.length > 0 ? quantile(good, 0.5) : 0,
+    speedupIQR: good.length > 0 ? [quantile(good, 0.25), quantile(good, 0.75)] : undefined,
+  };
+}
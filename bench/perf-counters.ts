@@ -0,0 +1,164 @@
+// hardware performance counters via `perf stat`
+// collected in one extra (untimed) run per binary so counting never skews the
+// timing samples. events the host doesn't support are probed once and dropped
+
+import { execFileSync } from "child_process";
+import { readFile, rm } from "fs/promises";
+
+export type PerfConfig = {
+  enabled: boolean;
+  events: string[]; // generic + pmu-specific names; unsupported ones are skipped
+  vectorEvents: string[]; // summed into vectorInstructions
+};
+
+export type PerfCounters = {
+  cycles?: number;
+  instructions?: number;
+  ipc?: number;
+  l1dMisses?: number;
+  llcMisses?: number;
+  dtlbMisses?: number;
+  branchMisses?: number;
+  vectorInstructions?: number;
+  raw: Record<string, number>; // every counted event by perf name
+};
+
+const FIELD_FOR_EVENT: Record<string, keyof Omit<PerfCounters, "raw" | "ipc" | "vectorInstructions">> = {
+  cycles: "cycles",
+  instructions: "instructions",
+  "L1-dcache-load-misses": "l1dMisses",
+  "LLC-load-misses": "llcMisses",
+  "dTLB-load-misses": "dtlbMisses",
+  "branch-misses": "branchMisses",
+};
+
+let perfWorks: boolean | null = null;
+const eventSupport = new Map<string, boolean>();
+
+export function perfAvailable(): boolean {
+  if (perfWorks === null) {
+    try {
+      execFileSync("perf", ["stat", "-x,", "-e", "instructions", "--", "true"], { stdio: "ignore" });
+      perfWorks = true;
+    } catch {
+      perfWorks = false;
+    }
+  }
+  return perfWorks;
+}
+
+function supportedEvents(events: string[]): string[] {
+  return events.filter((event) => {
+    let ok = eventSupport.get(event);
+    if (ok === undefined) {
+      try {
+        const out = execFileSync("perf", ["stat", "-x,", "-o", "/dev/stdout", "-e", event, "--", "true"], {
+          encoding: "utf-8",
+          stdio: ["ignore", "pipe", "ignore"],
+        });
+        ok = !/not supported|<not counted>/.test(out);
+      } catch {
+        ok = false;
+      }
+      eventSupport.set(event, ok);
+    }
+    return ok;
+  });
+}
+
+// perf stat -x, lines look like: value,unit,event,runtime,percent,...
+export function parsePerfCsv(csv: string, vectorEvents: string[]): PerfCounters {
+  const counters: PerfCounters = { raw: {} };
+
+  for (const line of csv.split("\n")) {
+    if (!line.trim() || line.startsWith("#")) continue;
+    const [value, , event] = line.split(",");
+    const n = Number(value);
+    if (!event || !Number.isFinite(n)) continue; // <not counted> / <not supported>
+
+    // perf may append modifiers like ":u"
+    const name = event.replace(/:[a-zA-Z]+$/, "");
+    counters.raw[name] = n;
+    const field = FIELD_FOR_EVENT[name];
+    if (field) counters[field] = n;
+  }
+
+  if (counters.cycles && counters.instructions !== undefined) {
+    counters.ipc = counters.instructions / counters.cycles;
+  }
+  const vector = vectorEvents.filter((e) => e in counters.raw);
+  if (vector.length > 0) {
+    counters.vectorInstructions = vector.reduce((sum, e) => sum + counters.raw[e], 0);
+  }
+  return counters;
+}
+
+// returns the perf wrapper for a command plus a reader for its counters
+export function perfStatCommand(
+  config: PerfConfig,
+  cmd: string,
+  args: string[],
+  outputFile: string
+): { cmd: string; args: string[]; read: () => Promise<PerfCounters | undefined> } | null {
+  if (!config.enabled || !perfAvailable()) return null;
+  const events = supportedEvents([...config.events, ...config.vectorEvents]);
+  if (events.length === 0) return null;
+
+  return {
+    cmd: "perf",
+    args: ["stat", "-x,", "-o", outputFile, "-e", events.join(","), "--", cmd, ...args],
+    read: async () => {
+      try {
+        return parsePerfCsv(await readFile(outputFile, "utf-8"), config.vectorEvents);
+      } catch {
+        return undefined;
+      } finally {
+        await rm(outputFile, { force: true });
+      }
+    },
+  };
+}
+
+export type Hotspot = {
+  symbol: string;
+  percent: number; // share of samples
+};
+
+// `perf record` for a command plus a reader for its hottest symbols; used for
+// refinement feedback, so no events to probe and no per-host tuning
+export function perfRecordCommand(
+  cmd: string,
+  args: string[],
+  dataFile: string,
+  limit = 5
+): { cmd: string; args: string[]; read: () => Promise<Hotspot[]> } | null {
+  if (!perfAvailable()) return null;
+  return {
+    cmd: "perf",
+    args: ["record", "-q", "-F", "999", "-o", dataFile, "--", cmd, ...args],
+    read: async () => {
+      try {
+        const report = execFileSync(
+          "perf",
+          ["report", "-i", dataFile, "--stdio", "--no-children", "--sort", "symbol", "--percent-limit", "1"],
+          { encoding: "utf-8", stdio: ["ignore", "pipe", "ignore"] }
+        );
+        return parsePerfReport(report).slice(0, limit);
+      } catch {
+        return [];
+      } finally {
+        await rm(dataFile, { force: true });
+      }
+    },
+  };
+}
+
+// perf report --sort symbol lines look like: "    42.50%  [.] multiply"
+export function parsePerfReport(report: string): Hotspot[] {
+  const hotspots: Hotspot[] = [];
+  for (const line of report.split("\n")) {
+    const m = line.match(/^\s*([\d.]+)%\s+\[[.k]\]\s+(.+?)\s*$/);
+    if (m) hotspots.push({ symbol: m[2], percent: Number(m[1]) });
+  }
+  return hotspots;
+}
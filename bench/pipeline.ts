@@ -0,0 +1,190 @@
+// staged benchmark pipeline
+// generate -> extract -> compile -> verify -> measure, with a bounded queue in
+// front of every stage and a separate concurrency limit per stage, so a slow
+// model request never holds up compiles or measurements for other jobs.
+// refinement rounds go back to the front of the generate queue
+
+import {
+  STAGES,
+  advanceRound,
+  createCandidate,
+  failCandidate,
+  resolveDuplicate,
+  settleCandidate,
+  type Candidate,
+  type OptimizationResult,
+  type StageName,
+  type TestJob,
+} from "./optimization-runner";
+import { getTimedScheduler } from "./scheduler";
+import type { WorkerPool } from "./worker-pool";
+import {
+  MAX_CONCURRENCY,
+  PIPELINE_QUEUE_CAPACITY,
+  SCHEDULER_CONFIG,
+  STAGGER_DELAY_MS,
+  WORKER_CONFIG,
+} from "./constants";
+import { cpus } from "os";
+
+export type PipelineConfig = {
+  concurrency: Record<StageName, number>;
+  queueCapacity: number; // max candidates waiting in front of a stage
+  staggerDelayMs: number; // min gap between consecutive model requests
+  workers?: WorkerPool; // compile, verify and measure remotely, as one "measure" stage
+};
+
+export type PipelineHooks = {
+  onStageStart?: (stage: StageName, job: TestJob) => void;
+  onResult?: (result: OptimizationResult, job: TestJob) => void;
+};
+
+// model requests are i/o bound and get MAX_CONCURRENCY; gcc and verify runs
+// get one slot per non-timing cpu; measurements get one per timing core
+export function defaultPipelineConfig(): PipelineConfig {
+  const scheduler = getTimedScheduler(SCHEDULER_CONFIG);
+  const hostCpus = scheduler.compileCpus?.length ?? cpus().length;
+  return {
+    concurrency: {
+      generate: MAX_CONCURRENCY,
+      extract: 4,
+      compile: hostCpus,
+      verify: hostCpus,
+      measure: scheduler.timingCpus.length,
+    },
+    queueCapacity: PIPELINE_QUEUE_CAPACITY,
+    staggerDelayMs: STAGGER_DELAY_MS,
+  };
+}
+
+type Channel<T> = {
+  push(item: T): Promise<void>; // waits while the channel is full
+  requeue(item: T): void; // to the front, ignoring capacity; for items already in the pipeline
+  pop(): Promise<T | undefined>; // undefined once closed and drained
+  close(): void;
+};
+
+function createChannel<T>(capacity: number): Channel<T> {
+  const items: T[] = [];
+  const poppers: Array<(item: T | undefined) => void> = [];
+  const pushers: Array<() => void> = [];
+  let closed = false;
+
+  return {
+    async push(item) {
+      const popper = poppers.shift();
+      if (popper) return popper(item);
+      while (items.length >= capacity) {
+        await new Promise<void>((resolve) => pushers.push(resolve));
+      }
+      items.push(item);
+    },
+    requeue(item) {
+      const popper = poppers.shift();
+      if (popper) return popper(item);
+      items.unshift(item);
+    },
+    async pop() {
+      if (items.length > 0) {
+        const item = items.shift()!;
+        pushers.shift()?.();
+        return item;
+      }
+      if (closed) return undefined;
+      return new Promise<T | undefined>((resolve) => poppers.push(resolve));
+    },
+    close() {
+      closed = true;
+      for (const popper of poppers.splice(0)) popper(undefined);
+    },
+  };
+}
+
+const sleep = (ms: number) => new Promise((resolve) => setTimeout(resolve, ms));
+
+export async function runPipeline(
+  jobs: TestJob[],
+  config: PipelineConfig,
+  hooks: PipelineHooks = {}
+): Promise<OptimizationResult[]> {
+  // remote: generate and extract (which dedupes) here, the rest on a worker.
+  // the stage admits a few more candidates than there are worker slots, so
+  // every worker has a queue for the others to steal from
+  const pool = config.workers;
+  const stages = pool
+    ? [...STAGES.slice(0, 2), { name: "measure" as const, run: (c: Candidate) => pool.measure(c) }]
+    : STAGES;
+  const concurrency = pool
+    ? { ...config.concurrency, measure: pool.slots * WORKER_CONFIG.queueDepth }
+    : config.concurrency;
+  const channels = stages.map(() => createChannel<Candidate>(config.queueCapacity));
+
+  // the generate queue stays open while any job may still need another round
+  const results: OptimizationResult[] = [];
+  let active = 0;
+  let fed = false;
+  const finish = (c: Candidate) => {
+    settleCandidate(c);
+    const next = advanceRound(c);
+    if (next) return channels[0].requeue(next);
+
+    results.push(c.result!);
+    hooks.onResult?.(c.result!, c.job);
+    if (--active === 0 && fed) channels[0].close();
+  };
+  // copies of already-seen code wait for that result outside every stage,
+  // so they never hold a slot the original still needs
+  const duplicates: Promise<void>[] = [];
+
+  // stagger model requests so providers don't see bursts
+  let nextRequestAt = 0;
+  const stagger = async () => {
+    const now = Date.now();
+    const wait = Math.max(0, nextRequestAt - now);
+    nextRequestAt = Math.max(now, nextRequestAt) + config.staggerDelayMs;
+    if (wait > 0) await sleep(wait);
+  };
+
+  const runStage = async (index: number) => {
+    const stage = stages[index];
+    const input = channels[index];
+    const output = channels[index + 1];
+
+    const worker = async () => {
+      for (;;) {
+        const c = await input.pop();
+        if (c === undefined) return;
+
+        if (stage.name === "generate") await stagger();
+        hooks.onStageStart?.(stage.name, c.job);
+
+        let next: Candidate;
+        try {
+          next = await stage.run(c);
+        } catch (err) {
+          next = failCandidate(c, { compileError: `Pipeline error in ${stage.name}: ${err}` });
+        }
+
+        if (next.original && !next.result) duplicates.push(resolveDuplicate(next).then(finish));
+        else if (next.result || !output) finish(next);
+        else await output.push(next);
+      }
+    };
+
+    await Promise.all(Array.from({ length: Math.max(1, concurrency[stage.name]) }, worker));
+    output?.close();
+  };
+
+  const stagesDone = Promise.all(stages.map((_, i) => runStage(i)));
+
+  for (const job of jobs) {
+    active++;
+    await channels[0].push(createCandidate(job, !!pool));
+  }
+  fed = true;
+  if (active === 0) channels[0].close();
+
+  await stagesDone;
+  await Promise.all(duplicates);
+  return results;
+}
@@ -0,0 +1,169 @@
+// prompt variants
+// a suite can declare alternative prompts, each run as its own matrix axis, to
+// see whether extra context (target flags, the hot function, baseline profile,
+// stricter rules) moves the speedup and what it costs in tokens and latency.
+// texts are templated with {{name}} placeholders filled from the test
+
+import type { BaselineEntry } from "./baseline-cache";
+import type { OptimizationResult, OptimizationTest } from "./optimization-runner";
+import type { Toolchain } from "./toolchain";
+import { countersLine } from "./refinement";
+import { hostFingerprint } from "./calibration";
+import { rankedSpeedup } from "./footprint";
+
+export type PromptVariant = {
+  id: string; // recorded on every result, part of the result key
+  description?: string;
+  system?: string; // replaces the suite's system prompt
+  prefix?: string; // before the default instructions
+  suffix?: string; // after the default instructions, before the code
+};
+
+// provider usage of one answer, refinement rounds summed
+export type TokenUsage = {
+  input: number;
+  output: number;
+  reasoning: number; // part of output, for models that report it
+  cachedInput: number;
+  total: number;
+};
+
+// placeholders a template may use; {{profile}} makes the request wait for the
+// primary baseline to be measured
+const PROFILE = "{{profile}}";
+
+export function needsProfile(v: PromptVariant | undefined): boolean {
+  return !!v && [v.system, v.prefix, v.suffix].some((t) => t?.includes(PROFILE));
+}
+
+export function profileText(entry: BaselineEntry): string {
+  const counters = entry.counters && countersLine(entry.counters);
+  const unit = entry.timingMode === "harness" ? "per kernel call" : "per run";
+  return `${entry.timeMs.toFixed(3)} ms ${unit} (median of ${entry.samplesMs.length})${counters ? `; ${counters}` : ""}`;
+}
+
+// "native" says nothing to a model; name the cpu the compiler resolves it to
+function targetCpu(toolchain: Toolchain, flags: string[]): string {
+  const march = flags.find((f) => f.startsWith("-march="))?.slice("-march=".length);
+  if (march !== "native") return march ?? "generic";
+  const resolved = hostFingerprint().nativeFlags[toolchain.compiler];
+  return resolved?.match(/-march=(\S+)/)?.[1] ?? resolved?.split(" ")[0] ?? hostFingerprint().cpuModel;
+}
+
+export function templateVars(
+  test: OptimizationTest,
+  toolchain: Toolchain,
+  baseline?: BaselineEntry | null
+): Record<string, string> {
+  const flags = [...toolchain.flags, ...(test.compilerFlags ?? [])];
+  return {
+    id: test.id,
+    name: test.name,
+    description: test.description,
+    language: test.language === "cpp" ? "C++20" : "C",
+    compiler: toolchain.compiler,
+    flags: flags.join(" "),
+    march: targetCpu(toolchain, flags),
+    kernel: test.harness?.kernel ?? "main",
+    profile: baseline ? profileText(baseline) : "not available",
+  };
+}
+
+// unknown placeholders are left in place so a typo shows up in the prompt
+export function renderTemplate(text: string, vars: Record<string, string>): string {
+  return text.replace(/\{\{(\w+)\}\}/g, (whole, name) => vars[name] ?? whole);
+}
+
+// ai sdk usage object, as stored with every generation
+export function tokenUsage(usage: unknown, totalTokens: number): TokenUsage {
+  const u = (usage ?? {}) as Record<string, number | undefined>;
+  return {
+    input: u.inputTokens ?? 0,
+    output: u.outputTokens ?? 0,
+    reasoning: u.reasoningTokens ?? 0,
+    cachedInput: u.cachedInputTokens ?? 0,
+    total: u.totalTokens ?? totalTokens,
+  };
+}
+
+export function addUsage(a: TokenUsage | undefined, b: TokenUsage | undefined): TokenUsage | undefined {
+  if (!a || !b) return a ?? b;
+  return {
+    input: a.input + b.input,
+    output: a.output + b.output,
+    reasoning: a.reasoning + b.reasoning,
+    cachedInput: a.cachedInput + b.cachedInput,
+    total: a.total + b.total,
+  };
+}
+
+type VariantTotals = {
+  model: string;
+  variant: string;
+  testsRun: number;
+  correct: number;
+  logSpeedupSum: number; // failures count as 1x, like the rankings
+  durationSum: number; // over `timed`, answers requested in this run
+  timed: number;
+  usage: TokenUsage;
+};
+
+export type VariantSummary = Map<string, VariantTotals>;
+
+export function addToVariants(totals: VariantSummary, r: OptimizationResult) {
+  if (!r.variant || r.infraError) return;
+  const key = `${r.model}\0${r.variant}`;
+  let t = totals.get(key);
+  if (!t) {
+    t = {
+      model: r.model,
+      variant: r.variant,
+      testsRun: 0,
+      correct: 0,
+      logSpeedupSum: 0,
+      durationSum: 0,
+      timed: 0,
+      usage: { input: 0, output: 0, reasoning: 0, cachedInput: 0, total: 0 },
+    };
+    totals.set(key, t);
+  }
+  t.testsRun++;
+  if (!r.generationCached) {
+    t.durationSum += r.duration;
+    t.timed++;
+  }
+  t.usage = addUsage(t.usage, r.usage ?? tokenUsage(undefined, r.tokensUsed))!;
+  const speedup = rankedSpeedup(r);
+  if (speedup > 0) {
+    t.correct++;
+    t.logSpeedupSum += Math.log(speedup);
+  }
+}
+
+// per (model, variant) speedup, pass rate and mean tokens / latency per
+// answer; speedupVsFirst is against the suite's first variant of the same model
+export function variantRankings(totals: VariantSummary, variants: PromptVariant[]) {
+  const order = new Map(variants.map((v, i) => [v.id, i]));
+  const rows = [...totals.values()].filter((t) => order.has(t.variant)).map((t) => {
+    const per = (x: number) => (t.testsRun > 0 ? x / t.testsRun : 0);
+    return {
+      model: t.model,
+      variant: t.variant,
+      testsRun: t.testsRun,
+      passRate: per(t.correct),
+      geomeanSpeedup: t.testsRun > 0 ? Math.exp(t.logSpeedupSum / t.testsRun) : 0,
+      avgTimeMs: t.timed > 0 ? t.durationSum / t.timed : NaN,
+      avgInputTokens: per(t.usage.input),
+      avgOutputTokens: per(t.usage.output),
+      avgReasoningTokens: per(t.usage.reasoning),
+      avgTotalTokens: per(t.usage.total),
+    };
+  });
+  const first = variants[0]?.id;
+  return rows
+    .map((row) => {
+      const base = rows.find((r) => r.model === row.model && r.variant === first);
+      return { ...row, speedupVsFirst: base && base.geomeanSpeedup > 0 ? row.geomeanSpeedup / base.geomeanSpeedup : undefined };
+    })
+    .sort((a, b) => a.model.localeCompare(b.model) || order.get(a.variant)! - order.get(b.variant)!);
+}
@@ -0,0 +1,144 @@
+// per-provider request limiting and retries
+// each provider gets a token bucket; a 429 pauses it for Retry-After and
+// halves its rate, successes bring the rate back. transient failures are
+// retried with jittered exponential backoff
+
+import type { LanguageModel } from "ai";
+
+export type BucketConfig = {
+  requestsPerMinute: number;
+  burst: number; // requests that may go out back to back
+};
+
+export type RateLimitConfig = {
+  providers: Record<string, BucketConfig>; // by providerKey()
+  fallback: BucketConfig;
+  retry: {
+    maxAttempts: number;
+    baseDelayMs: number;
+    maxDelayMs: number;
+  };
+};
+
+export type FailureKind = "rate-limit" | "provider" | "network" | "timeout" | "request";
+
+type Bucket = {
+  config: BucketConfig;
+  tokens: number;
+  ratePerMs: number; // current, at most the configured rate
+  updatedAt: number;
+  pausedUntil: number;
+};
+
+const buckets = new Map<string, Bucket>();
+const sleep = (ms: number) => new Promise((resolve) => setTimeout(resolve, ms));
+
+// "openrouter", "openrouter:free", "google", ...; free openrouter models share
+// a much smaller budget than paid ones
+export function providerKey(llm: LanguageModel): string {
+  if (typeof llm === "string") return "gateway";
+  const provider = llm.provider.split(".")[0];
+  return llm.modelId.endsWith(":free") ? `${provider}:free` : provider;
+}
+
+function bucketFor(key: string, config: RateLimitConfig): Bucket {
+  let bucket = buckets.get(key);
+  if (!bucket) {
+    const bc = config.providers[key] ?? config.fallback;
+    bucket = {
+      config: bc,
+      tokens: bc.burst,
+      ratePerMs: bc.requestsPerMinute / 60000,
+      updatedAt: Date.now(),
+      pausedUntil: 0,
+    };
+    buckets.set(key, bucket);
+  }
+  return bucket;
+}
+
+async function acquire(bucket: Bucket) {
+  for (;;) {
+    const now = Date.now();
+    bucket.tokens = Math.min(bucket.config.burst, bucket.tokens + (now - bucket.updatedAt) * bucket.ratePerMs);
+    bucket.updatedAt = now;
+    if (now < bucket.pausedUntil) {
+      await sleep(bucket.pausedUntil - now);
+    } else if (bucket.tokens >= 1) {
+      bucket.tokens -= 1;
+      return;
+    } else {
+      await sleep(Math.ceil((1 - bucket.tokens) / bucket.ratePerMs));
+    }
+  }
+}
+
+// additive increase on success, multiplicative decrease on 429
+function adapt(bucket: Bucket, limited: boolean, retryAfterMs?: number) {
+  const configured = bucket.config.requestsPerMinute / 60000;
+  if (limited) {
+    bucket.ratePerMs = Math.max(configured / 16, bucket.ratePerMs / 2);
+    bucket.tokens = Math.min(bucket.tokens, 0);
+    if (retryAfterMs) bucket.pausedUntil = Math.max(bucket.pausedUntil, Date.now() + retryAfterMs);
+  } else {
+    bucket.ratePerMs = Math.min(configured, bucket.ratePerMs + configured / 16);
+  }
+}
+
+// Retry-After is seconds or an http date; openrouter also sends the reset as
+// epoch milliseconds
+function retryAfterMs(headers: Record<string, string> | undefined): number | undefined {
+  if (!headers) return undefined;
+  const h = Object.fromEntries(Object.entries(headers).map(([k, v]) => [k.toLowerCase(), v]));
+  const after = h["retry-after"];
+  if (after) {
+    const seconds = Number(after);
+    const ms = Number.isFinite(seconds) ? seconds * 1000 : Date.parse(after) - Date.now();
+    if (ms > 0) return ms;
+  }
+  const reset = Number(h["x-ratelimit-reset"]);
+  if (Number.isFinite(reset) && reset > Date.now()) return reset - Date.now();
+  return undefined;
+}
+
+export function classifyFailure(err: any): { kind: FailureKind; retryable: boolean; retryAfterMs?: number } {
+  if (err?.name === "TimeoutError" || err?.name === "AbortError") return { kind: "timeout", retryable: false };
+  const status: number | undefined = err?.statusCode;
+  if (status === 429) return { kind: "rate-limit", retryable: true, retryAfterMs: retryAfterMs(err.responseHeaders) };
+  if (status !== undefined && (status >= 500 || status === 408)) return { kind: "provider", retryable: true };
+  if (status === undefined && /fetch failed|ECONNRESET|ETIMEDOUT|ENOTFOUND|EAI_AGAIN|socket|network/i.test(String(err?.message ?? err))) {
+    return { kind: "network", retryable: true };
+  }
+  return { kind: "request", retryable: err?.isRetryable === true };
+}
+
+// runs one model request under the provider's bucket; each attempt gets its
+// own deadline. the error thrown after the last attempt says what kind of
+// failure it was and how many attempts were made
+export async function withRateLimit<T>(
+  key: string,
+  config: RateLimitConfig,
+  timeoutMs: number | undefined,
+  request: (signal: AbortSignal | undefined) => Promise<T>
+): Promise<T> {
+  const bucket = bucketFor(key, config);
+  const { maxAttempts, baseDelayMs, maxDelayMs } = config.retry;
+
+  for (let attempt = 1; ; attempt++) {
+    await acquire(bucket);
+    try {
+      const result = await request(timeoutMs ? AbortSignal.timeout(timeoutMs) : undefined);
+      adapt(bucket, false);
+      return result;
+    } catch (err) {
+      const failure = classifyFailure(err);
+      if (failure.kind === "rate-limit") adapt(bucket, true, failure.retryAfterMs);
+      if (!failure.retryable || attempt >= maxAttempts) {
+        throw new Error(`${failure.kind} after ${attempt} attempt${attempt > 1 ? "s" : ""}: ${err}`, { cause: err });
+      }
+      // full jitter, but never earlier than the provider asked for
+      const backoff = Math.random() * Math.min(maxDelayMs, baseDelayMs * 2 ** (attempt - 1));
+      await sleep(Math.max(backoff, failure.retryAfterMs ?? 0));
+    }
+  }
+}
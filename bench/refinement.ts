@@ -0,0 +1,118 @@
+// iterative refinement
+// after each round the model is told what happened (compile error, where its
+// output went wrong, or timing + a short profile) and asked for a better
+// version; the best verified round becomes the result
+
+import { describeMismatch } from "./oracle";
+import type { Hotspot, PerfCounters } from "./perf-counters";
+import type { OptimizationResult } from "./optimization-runner";
+
+export type RefineConfig = {
+  rounds: number; // feedback rounds after the first answer, 0 = single shot
+  profile: boolean; // perf record the candidate for hot functions (when perf works)
+  maxFeedbackChars: number; // compiler errors and outputs are cut to this
+};
+
+export type RefineRound = {
+  round: number; // 0 = the first answer
+  compiled: boolean;
+  correct: boolean;
+  speedup: number;
+  optimizedTimeMs: number;
+  error?: string; // first line of the compile / verify error
+};
+
+export type Refinement = {
+  rounds: RefineRound[];
+  bestRound: number;
+};
+
+export function refineRound(round: number, r: OptimizationResult): RefineRound {
+  return {
+    round,
+    compiled: r.compiled,
+    correct: r.correct && !r.footprintCap, // over a footprint cap ranks as a failure
+    speedup: r.speedup,
+    optimizedTimeMs: r.optimizedTimeMs,
+    error: r.compileError?.split("\n")[0] || undefined,
+  };
+}
+
+// the fastest correct round, or the last one if none was correct
+export function bestRound(rounds: RefineRound[]): number {
+  const correct = rounds.filter((r) => r.correct);
+  if (correct.length === 0) return rounds[rounds.length - 1].round;
+  return correct.reduce((best, r) => (r.speedup > best.speedup ? r : best)).round;
+}
+
+const clip = (text: string, max: number) =>
+  text.length > max ? `${text.slice(0, max)}\n... (${text.length - max} more characters)` : text;
+
+export function countersLine(c: PerfCounters): string | null {
+  const parts = [
+    c.ipc !== undefined ? `IPC ${c.ipc.toFixed(2)}` : null,
+    c.l1dMisses !== undefined ? `${c.l1dMisses.toExponential(2)} L1d misses` : null,
+    c.llcMisses !== undefined ? `${c.llcMisses.toExponential(2)} LLC misses` : null,
+    c.dtlbMisses !== undefined ? `${c.dtlbMisses.toExponential(2)} dTLB misses` : null,
+    c.branchMisses !== undefined ? `${c.branchMisses.toExponential(2)} branch misses` : null,
+  ].filter(Boolean);
+  return parts.length > 0 ? parts.join(", ") : null;
+}
+
+export function feedbackMessage(r: OptimizationResult, hotspots: Hotspot[], config: RefineConfig): string {
+  const ask = "Return ONLY the complete program, no explanations.";
+
+  if (!r.optimizedCode) return `No code block was found in that answer. ${ask}`;
+
+  if (!r.compiled) {
+    const error = r.compileError ?? "unknown error";
+    return `That version failed to build:\n\n\`\`\`\n${clip(error, config.maxFeedbackChars)}\n\`\`\`\n\nFix it. ${ask}`;
+  }
+
+  if (!r.correct) {
+    const lines: string[] = [];
+    if (r.compileError) {
+      // runtime errors and timeouts are reported through compileError
+      lines.push(`That version compiled but failed when run:\n\n\`\`\`\n${clip(r.compileError, config.maxFeedbackChars)}\n\`\`\``);
+    } else if (r.oracle?.mismatch) {
+      lines.push(`That version is incorrect on randomized inputs: ${r.oracle.mismatch}.`);
+    } else if (r.actualOutput !== undefined && r.expectedOutput !== undefined) {
+      // only where it went wrong and what it printed; the reference output
+      // would let a program that just prints it pass the next round
+      lines.push(
+        `That version is incorrect; its output differs from the original's at ${describeMismatch(r.actualOutput, r.expectedOutput)}.`,
+        `It printed:\n\`\`\`\n${clip(r.actualOutput, config.maxFeedbackChars)}\n\`\`\``
+      );
+    } else {
+      lines.push("That version is incorrect.");
+    }
+    lines.push(`Fix it while keeping it fast. ${ask}`);
+    return lines.join("\n\n");
+  }
+
+  const lines = [
+    `That version is correct: ${r.optimizedTimeMs.toFixed(2)} ms vs ${r.baselineTimeMs.toFixed(2)} ms for the original (${r.speedup.toFixed(2)}x).`,
+  ];
+  const counters = r.optimizedCounters && countersLine(r.optimizedCounters);
+  if (counters) lines.push(`Counters: ${counters}.`);
+  if (r.optimizedRoofline) {
+    const roof = { flops: "floating-point peak", ops: "integer peak", bytes: "memory bandwidth" }[r.optimizedRoofline.bound];
+    lines.push(`That is ${(r.optimizedRoofline.percent * 100).toFixed(0)}% of this machine's roofline, bound by its ${roof}.`);
+  }
+  if (hotspots.length > 0) {
+    lines.push(`Hot functions:\n${hotspots.map((h) => `  ${h.percent.toFixed(1)}%  ${h.symbol}`).join("\n")}`);
+  }
+  if (r.scaling?.optimizedExponent !== undefined) {
+    lines.push(`Time grows as n^${r.scaling.optimizedExponent.toFixed(2)} over ${r.scaling.param}.`);
+  }
+  if (r.threadScaling?.efficiencyAtMax !== undefined) {
+    lines.push(
+      `Parallel efficiency at ${r.threadScaling.maxThreads} threads: ${(r.threadScaling.efficiencyAtMax * 100).toFixed(0)}%.`
+    );
+  }
+  if (r.footprintCap) {
+    lines.push(`It is rejected anyway: ${r.footprintCap}. Avoid large precomputed tables and unrolling that bloats the build.`);
+  }
+  lines.push(`Make it faster; the output must stay identical. ${ask}`);
+  return lines.join("\n\n");
+}
@@ -0,0 +1,134 @@
+// regression tracking across stored runs
+// diffs two versions (optionally pinned to a host) per (model, test) and builds
+// the per-version trend series the visualizer plots. a median speedup change
+// counts when its bootstrap CI excludes 1x, a pass-rate change when a
+// two-proportion z-test says so
+
+import { mergePairs, splitPairKey, type IndexedRun, type PairStats } from "./run-index";
+import { median, speedupInterval } from "./sampling";
+import { COMPARE_CONFIG } from "./constants";
+
+// "<version>" or "<version>@<host substring>"
+export type RunSelector = { version: string; host?: string };
+
+export function parseSelector(text: string): RunSelector {
+  const at = text.indexOf("@");
+  return at < 0 ? { version: text } : { version: text.slice(0, at), host: text.slice(at + 1) };
+}
+
+export function selectRuns(runs: IndexedRun[], suiteId: string, s: RunSelector): IndexedRun[] {
+  return runs.filter(
+    (r) => r.suiteId === suiteId && r.version === s.version && (!s.host || (r.host ?? "").includes(s.host))
+  );
+}
+
+export type SideStats = { samples: number; passRate: number; medianSpeedup: number };
+
+export type PairDiff = {
+  model: string;
+  testId: string;
+  a: SideStats;
+  b: SideStats;
+  speedupRatio: number; // median speedup of b / a
+  speedupRatioCI?: [number, number]; // 95% bootstrap, when both sides have enough correct samples
+  passRateDelta: number; // b - a
+  status: "improved" | "regressed" | "unchanged";
+};
+
+const side = (p: PairStats): SideStats => ({
+  samples: p.samples,
+  passRate: p.samples > 0 ? p.correct / p.samples : 0,
+  medianSpeedup: median(p.speedups),
+});
+
+// pooled two-proportion z statistic, 0 when either side is empty or nothing varies
+function proportionZ(a: PairStats, b: PairStats): number {
+  if (a.samples === 0 || b.samples === 0) return 0;
+  const pooled = (a.correct + b.correct) / (a.samples + b.samples);
+  const se = Math.sqrt(pooled * (1 - pooled) * (1 / a.samples + 1 / b.samples));
+  return se > 0 ? (b.correct / b.samples - a.correct / a.samples) / se : 0;
+}
+
+// every (model, test) present on both sides, regressions first
+export function diffRuns(a: IndexedRun[], b: IndexedRun[]): PairDiff[] {
+  const before = mergePairs(a);
+  const after = mergePairs(b);
+  const diffs: PairDiff[] = [];
+
+  for (const [key, pa] of before) {
+    const pb = after.get(key);
+    if (!pb) continue;
+    const sa = side(pa);
+    const sb = side(pb);
+    const enough = pa.speedups.length >= COMPARE_CONFIG.minSamples && pb.speedups.length >= COMPARE_CONFIG.minSamples;
+    const ci = enough ? speedupInterval(pb.speedups, pa.speedups) : undefined;
+    const z = proportionZ(pa, pb);
+
+    const speedupDown = !!ci && ci[1] < 1;
+    const speedupUp = !!ci && ci[0] > 1;
+    const passDown = z < -COMPARE_CONFIG.zCritical;
+    const passUp = z > COMPARE_CONFIG.zCritical;
+
+    diffs.push({
+      ...splitPairKey(key),
+      a: sa,
+      b: sb,
+      speedupRatio: sa.medianSpeedup > 0 ? sb.medianSpeedup / sa.medianSpeedup : 0,
+      speedupRatioCI: ci,
+      passRateDelta: sb.passRate - sa.passRate,
+      status: speedupDown || passDown ? "regressed" : speedupUp || passUp ? "improved" : "unchanged",
+    });
+  }
+
+  const order = { regressed: 0, improved: 1, unchanged: 2 };
+  return diffs.sort((x, y) => order[x.status] - order[y.status] || x.speedupRatio - y.speedupRatio);
+}
+
+export type TrendPoint = SideStats & {
+  version: string;
+  host?: string;
+  timestamp: string; // earliest run of the (version, host)
+};
+
+export type TrendSeries = { model: string; testId: string; points: TrendPoint[] };
+
+export type Trends = {
+  suiteId: string;
+  generatedAt: string;
+  versions: Array<{ version: string; host?: string; timestamp: string }>;
+  series: TrendSeries[];
+};
+
+// one point per (version, host) in run order, for every (model, test) of the suite
+export function trendSeries(runs: IndexedRun[], suiteId: string): Trends {
+  const groups = new Map<string, IndexedRun[]>();
+  for (const run of runs.filter((r) => r.suiteId === suiteId)) {
+    const key = `${run.version}\n${run.host ?? ""}`;
+    (groups.get(key) ?? groups.set(key, []).get(key)!).push(run);
+  }
+
+  const versions = [...groups.values()]
+    .map((g) => ({
+      version: g[0].version,
+      host: g[0].host,
+      timestamp: g.map((r) => r.timestamp).sort()[0],
+      pairs: mergePairs(g),
+    }))
+    .sort((x, y) => x.timestamp.localeCompare(y.timestamp));
+
+  const keys = [...new Set(versions.flatMap((v) => [...v.pairs.keys()]))].sort();
+  const series = keys.map((key) => ({
+    ...splitPairKey(key),
+    points: versions.flatMap(({ pairs, ...v }) => {
+      const p = pairs.get(key);
+      return p ? [{ ...v, ...side(p) }] : [];
+    }),
+  }));
+
+  return {
+    suiteId,
+    generatedAt: new Date().toISOString(),
+    versions: versions.map(({ pairs: _pairs, ...v }) => v),
+    series,
+  };
+}
@@ -0,0 +1,247 @@
+// append-only results log
+// one OptimizationResult per line, written as each job finishes and fsynced in
+// batches, so an interrupted run keeps everything but the last batch and can
+// be resumed; the summary is folded from the same stream
+
+import { closeSync, existsSync, fsyncSync, openSync, writeSync } from "fs";
+import { readFile } from "fs/promises";
+import type { OptimizationResult } from "./optimization-runner";
+import { PASS_AT_K, sampleMetrics, type SampleMetrics } from "./pass-at-k";
+import { rankedSpeedup } from "./footprint";
+
+export type ResultsLogConfig = {
+  flushEvery: number; // results buffered before a write + fsync
+  flushIntervalMs: number; // upper bound on how long a result sits in the buffer
+};
+
+export type ResultsLog = {
+  append(result: OptimizationResult): void;
+  flush(): void;
+  close(): void;
+};
+
+// (model, test, sample) identifies a job across runs, plus the prompt
+// variant for suites that declare them
+export function resultKey(r: { model: string; testId: string; sample?: number; variant?: string }): string {
+  const key = `${r.model}\0${r.testId}\0${r.sample ?? 0}`;
+  return r.variant ? `${key}\0${r.variant}` : key;
+}
+
+export function openResultsLog(file: string, config: ResultsLogConfig): ResultsLog {
+  const fd = openSync(file, "a");
+  let buffer: string[] = [];
+  let closed = false;
+
+  const flush = () => {
+    if (buffer.length === 0 || closed) return;
+    writeSync(fd, buffer.join(""));
+    fsyncSync(fd);
+    buffer = [];
+  };
+
+  const timer = setInterval(flush, config.flushIntervalMs);
+  timer.unref();
+  // crashes still get the partial batch out through "exit", which signals
+  // skip: those flush, then re-raise so the process dies as it would have
+  process.on("exit", flush);
+  const onSignal = (signal: NodeJS.Signals) => {
+    flush();
+    process.off("SIGINT", onSignal);
+    process.off("SIGTERM", onSignal);
+    if (process.listenerCount(signal) === 0) process.kill(process.pid, signal);
+  };
+  process.on("SIGINT", onSignal);
+  process.on("SIGTERM", onSignal);
+
+  return {
+    append(result) {
+      buffer.push(JSON.stringify(result) + "\n");
+      if (buffer.length >= config.flushEvery) flush();
+    },
+    flush,
+    close() {
+      flush();
+      clearInterval(timer);
+      process.off("exit", flush);
+      process.off("SIGINT", onSignal);
+      process.off("SIGTERM", onSignal);
+      closeSync(fd);
+      closed = true;
+    },
+  };
+}
+
+// a run killed mid-write leaves a truncated last line, which is dropped
+export async function readResultsLog(file: string): Promise<OptimizationResult[]> {
+  if (!existsSync(file)) return [];
+  const results: OptimizationResult[] = [];
+  for (const line of (await readFile(file, "utf-8")).split("\n")) {
+    if (!line.trim()) continue;
+    try {
+      results.push(JSON.parse(line));
+    } catch {
+      // partial line
+    }
+  }
+  return results;
+}
+
+type ModelTotals = {
+  testsRun: number;
+  infraErrors: number; // requests that never produced an answer, not in any rate
+  compiled: number;
+  correct: number;
+  speedupSum: number;
+  logSpeedupSum: number; // ln speedup per result, failures count as 1x
+  maxSpeedup: number;
+  suspectConstantTime: number;
+  footprintCapped: number; // correct, but over a compile time / size / startup cap
+  memoryRatioSum: number;
+  memoryRatios: number;
+  rooflineSum: number; // percent of roofline of the version each result keeps
+  rooflines: number;
+  durationSum: number; // over `timed`, results whose request ran in this run
+  timed: number;
+  costSum: number;
+  costed: number; // results with a known cost
+  speedups: Map<string, number[]>; // per test, one per sample, 0 unless correct
+};
+
+export type SummaryTotals = Map<string, ModelTotals>;
+
+export function addToSummary(totals: SummaryTotals, r: OptimizationResult) {
+  let t = totals.get(r.model);
+  if (!t) {
+    t = {
+      testsRun: 0,
+      infraErrors: 0,
+      compiled: 0,
+      correct: 0,
+      speedupSum: 0,
+      logSpeedupSum: 0,
+      maxSpeedup: 0,
+      suspectConstantTime: 0,
+      footprintCapped: 0,
+      memoryRatioSum: 0,
+      memoryRatios: 0,
+      rooflineSum: 0,
+      rooflines: 0,
+      durationSum: 0,
+      timed: 0,
+      costSum: 0,
+      costed: 0,
+      speedups: new Map(),
+    };
+    totals.set(r.model, t);
+  }
+  if (r.infraError) {
+    t.infraErrors++;
+    return;
+  }
+
+  const perTest = t.speedups.get(r.testId) ?? [];
+  perTest.push(rankedSpeedup(r));
+  t.speedups.set(r.testId, perTest);
+
+  t.testsRun++;
+  // a stored answer's latency and cost belong to the run that requested it
+  if (!r.generationCached) {
+    t.durationSum += r.duration;
+    t.timed++;
+  }
+  if (r.costUsd !== undefined && !r.generationCached) {
+    t.costSum += r.costUsd;
+    t.costed++;
+  }
+  if (r.compiled) t.compiled++;
+  // the candidate when it ranks, else the original it leaves in place; capped at
+  // 100% so an overstated work declaration can't carry a model
+  const roofline = rankedSpeedup(r) > 0 ? r.optimizedRoofline : r.baselineRoofline;
+  if (roofline) {
+    t.rooflineSum += Math.min(roofline.percent, 1);
+    t.rooflines++;
+  }
+  if (!r.correct) return;
+  if (r.footprintCap) {
+    t.footprintCapped++;
+    return;
+  }
+
+  t.correct++;
+  // discounted for compile time / binary growth, see FOOTPRINT_CONFIG
+  const speedup = rankedSpeedup(r);
+  t.speedupSum += speedup;
+  // a pipeline keeps the original when a candidate fails, so failures stay at
+  // ln 1 = 0; correct slowdowns count against the model
+  if (speedup > 0) t.logSpeedupSum += Math.log(speedup);
+  t.maxSpeedup = Math.max(t.maxSpeedup, speedup);
+  // correct, but the time stayed flat while the input grew
+  if (r.suspectConstantTime) t.suspectConstantTime++;
+  // optimized / baseline peak rss, <1 means the rewrite uses less memory
+  if (r.baselineResources?.maxRssKb && r.optimizedResources) {
+    t.memoryRatioSum += r.optimizedResources.maxRssKb / r.baselineResources.maxRssKb;
+    t.memoryRatios++;
+  }
+}
+
+// per-test sample metrics averaged over tests; a k is only reported when
+// every test has at least k samples
+function modelSampleMetrics(speedups: Map<string, number[]>) {
+  const tests: Record<string, SampleMetrics> = {};
+  for (const [testId, values] of speedups) tests[testId] = sampleMetrics(values);
+  const all = Object.values(tests);
+  const mean = (f: (m: SampleMetrics) => number) =>
+    all.length > 0 ? all.reduce((sum, m) => sum + f(m), 0) / all.length : 0;
+
+  const passAt: Record<number, number> = {};
+  const bestOfK: Record<number, number> = {};
+  for (const k of PASS_AT_K) {
+    if (all.length === 0 || all.some((m) => m.passAt[k] === undefined)) continue;
+    passAt[k] = mean((m) => m.passAt[k]);
+    bestOfK[k] = mean((m) => m.bestOfK[k]);
+  }
+  return {
+    samplesPerTest: all.length > 0 ? Math.min(...all.map((m) => m.samples)) : 0,
+    passAt,
+    bestOfK,
+    medianSpeedup: mean((m) => m.medianSpeedup),
+    tests,
+  };
+}
+
+// rankings for summary-<ts>.json, best geometric-mean speedup first: unlike
+// the arithmetic average one outlier test can't carry a model. cost and
+// latency rates are that speedup per average dollar / second of generation
+export function summaryRankings(totals: SummaryTotals, models: string[]) {
+  return models
+    .map((model) => {
+      const t = totals.get(model);
+      const geomeanSpeedup = t && t.testsRun > 0 ? Math.exp(t.logSpeedupSum / t.testsRun) : 0;
+      const averageCostPerTest = t && t.costed > 0 ? t.costSum / t.costed : undefined;
+      const avgTimeMs = t && t.timed > 0 ? t.durationSum / t.timed : NaN;
+      return {
+        model,
+        testsRun: t?.testsRun ?? 0,
+        infraErrors: t?.infraErrors ?? 0,
+        compiled: t?.compiled ?? 0,
+        correct: t?.correct ?? 0,
+        geomeanSpeedup,
+        avgSpeedup: t && t.correct > 0 ? t.speedupSum / t.correct : 0,
+        maxSpeedup: t?.maxSpeedup ?? 0,
+        suspectConstantTime: t?.suspectConstantTime ?? 0,
+        footprintCapped: t?.footprintCapped ?? 0,
+        avgMemoryRatio: t && t.memoryRatios > 0 ? t.memoryRatioSum / t.memoryRatios : undefined,
+        // over the tests whose harness declares its work
+        avgRooflinePercent: t && t.rooflines > 0 ? t.rooflineSum / t.rooflines : undefined,
+        rooflineTests: t?.rooflines ?? 0,
+        avgTimeMs,
+        totalCost: t && t.costed > 0 ? t.costSum : undefined,
+        averageCostPerTest,
+        speedupPerDollar: averageCostPerTest ? geomeanSpeedup / averageCostPerTest : undefined,
+        speedupPerSecond: avgTimeMs > 0 ? geomeanSpeedup / (avgTimeMs / 1000) : undefined,
+        // repeated sampling: pass@k, best-of-k and the median / IQR spread per test
+        ...modelSampleMetrics(t?.speedups ?? new Map()),
+      };
+    })
+    .sort((a, b) => b.geomeanSpeedup - a.geomeanSpeedup);
+}
@@ -0,0 +1,178 @@
+// roofline efficiency
+// a harness spec can declare the work one kernel call needs (flops, bytes,
+// other ops such as compares). against the host's single-core peaks, measured
+// once with the calibration, that gives the least time the call could take;
+// percent of roofline is that bound over the measured time, comparable across
+// tests in a way raw speedups aren't
+
+import { runCommand } from "./command";
+import { farmBuild } from "./compile-farm";
+import type { Toolchain } from "./toolchain";
+import { SANDBOX_CONFIG } from "./constants";
+
+export type RooflineConfig = {
+  enabled: boolean;
+  loops: number; // iterations of each compute kernel, per repeat
+  repeats: number; // compute peaks are the best repeat
+  streamDoubles: number; // elements per triad array, far beyond the last-level cache
+  passes: number; // triad passes, bandwidth is the best one
+};
+
+// what one core reaches with the primary toolchain's flags
+export type HostPeaks = {
+  gflops: number; // independent fused multiply-adds, 2 flops each
+  gops: number; // independent 32-bit integer xor + add
+  gbs: number; // stream triad, 24 bytes per element
+};
+
+// work per kernel call, from the harness spec's expressions
+export type HarnessWork = {
+  bytes?: number;
+  flops?: number;
+  ops?: number;
+};
+
+export type Roofline = {
+  gflops?: number; // achieved, for the declared work
+  gops?: number;
+  gbs?: number;
+  bound: "flops" | "ops" | "bytes"; // the resource that sets the least time
+  percent: number; // least time / measured time, 0..1 (can exceed 1 when the declared work is an overestimate)
+};
+
+// the chains are plain arrays the vectorizer keeps in registers; an argv
+// dependent operand stops the compiler from folding the loops
+const PEAK_KERNEL = `#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#define FP_CHAINS 64
+#define INT_CHAINS 128
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static volatile double sink_fp;
+static volatile uint32_t sink_int;
+
+static double peak_gflops(long loops, double m, double a) {
+  double acc[FP_CHAINS];
+  for (int j = 0; j < FP_CHAINS; j++) acc[j] = 1.0 + j * 1e-3;
+  uint64_t t0 = now_ns();
+  for (long i = 0; i < loops; i++) {
+    for (int j = 0; j < FP_CHAINS; j++) acc[j] = acc[j] * m + a;
+  }
+  uint64_t t1 = now_ns();
+  double s = 0;
+  for (int j = 0; j < FP_CHAINS; j++) s += acc[j];
+  sink_fp = s;
+  return 2.0 * FP_CHAINS * loops / (double)(t1 - t0);
+}
+
+static double peak_gops(long loops, uint32_t k) {
+  uint32_t acc[INT_CHAINS];
+  for (int j = 0; j < INT_CHAINS; j++) acc[j] = (uint32_t)j * 2654435761u;
+  uint64_t t0 = now_ns();
+  for (long i = 0; i < loops; i++) {
+    for (int j = 0; j < INT_CHAINS; j++) acc[j] = (acc[j] ^ k) + (uint32_t)j;
+  }
+  uint64_t t1 = now_ns();
+  uint32_t s = 0;
+  for (int j = 0; j < INT_CHAINS; j++) s += acc[j];
+  sink_int = s;
+  return 2.0 * INT_CHAINS * loops / (double)(t1 - t0);
+}
+
+static double peak_gbs(long n, int passes, double scalar) {
+  double *a = malloc(n * sizeof(double));
+  double *b = malloc(n * sizeof(double));
+  double *c = malloc(n * sizeof(double));
+  if (!a || !b || !c) return 0;
+  for (long i = 0; i < n; i++) {
+    a[i] = 0.0;
+    b[i] = (double)(i % 1000);
+    c[i] = (double)(i % 7);
+  }
+  uint64_t best = UINT64_MAX;
+  for (int p = 0; p < passes; p++) {
+    uint64_t t0 = now_ns();
+    for (long i = 0; i < n; i++) a[i] = b[i] + scalar * c[i];
+    uint64_t t1 = now_ns();
+    __asm__ volatile("" : : "r"(a) : "memory");
+    if (t1 - t0 < best) best = t1 - t0;
+  }
+  sink_fp = a[n / 2];
+  free(a);
+  free(b);
+  free(c);
+  return 3.0 * sizeof(double) * n / (double)best;
+}
+
+int main(int argc, char **argv) {
+  long loops = argc > 1 ? atol(argv[1]) : 10000000;
+  int repeats = argc > 2 ? atoi(argv[2]) : 3;
+  long n = argc > 3 ? atol(argv[3]) : 1L << 23;
+  int passes = argc > 4 ? atoi(argv[4]) : 10;
+  double gflops = 0, gops = 0;
+  for (int r = 0; r < repeats; r++) {
+    double f = peak_gflops(loops, 0.9999999, 1e-9 * argc);
+    double o = peak_gops(loops, (uint32_t)argc);
+    if (f > gflops) gflops = f;
+    if (o > gops) gops = o;
+  }
+  printf("peak_gflops %.3f\\n", gflops);
+  printf("peak_gops %.3f\\n", gops);
+  printf("peak_gbs %.3f\\n", peak_gbs(n, passes, 0.5 + argc));
+  return 0;
+}
+`;
+
+// runs on the calibration's timing core; undefined when disabled or the kernel
+// doesn't build
+export async function measurePeaks(
+  tc: Toolchain,
+  cpus: number[] | null,
+  config: RooflineConfig
+): Promise<HostPeaks | undefined> {
+  if (!config.enabled) return undefined;
+  const build = await farmBuild({ ...tc, pgo: false }, PEAK_KERNEL, []);
+  if (!build.success) return undefined;
+  const args = [config.loops, config.repeats, config.streamDoubles, config.passes].map(String);
+  const run = await runCommand(build.binary, args, { timeout: 120000, cpus, sandbox: SANDBOX_CONFIG });
+  if (run.exitCode !== 0) return undefined;
+  const peak = (name: string) => Number(run.stdout.match(new RegExp(`^peak_${name} ([\\d.]+)`, "m"))?.[1] ?? 0);
+  const peaks = { gflops: peak("gflops"), gops: peak("gops"), gbs: peak("gbs") };
+  return peaks.gflops > 0 && peaks.gops > 0 && peaks.gbs > 0 ? peaks : undefined;
+}
+
+// classic roofline with one roof per declared resource: the least time is the
+// slowest of work / peak over them, which is min(peak, intensity * bandwidth)
+// for a single compute roof. bytes are the least traffic the kernel needs, so
+// a cache-resident kernel can read above 100%
+export function rooflineScore(work: HarnessWork | undefined, timeMs: number, peaks: HostPeaks | undefined): Roofline | undefined {
+  if (!work || !peaks || timeMs <= 0) return undefined;
+  const seconds = timeMs / 1000;
+  const roofs = (
+    [
+      ["flops", work.flops, peaks.gflops],
+      ["ops", work.ops, peaks.gops],
+      ["bytes", work.bytes, peaks.gbs],
+    ] as const
+  ).filter(([, amount]) => amount !== undefined && amount > 0);
+  if (roofs.length === 0) return undefined;
+
+  const leastSeconds = roofs.map(([bound, amount, peak]) => ({ bound, seconds: amount! / (peak * 1e9) }));
+  const limit = leastSeconds.reduce((a, b) => (b.seconds > a.seconds ? b : a));
+  const rate = (amount?: number) => (amount ? amount / seconds / 1e9 : undefined);
+  return {
+    gflops: rate(work.flops),
+    gops: rate(work.ops),
+    gbs: rate(work.bytes),
+    bound: limit.bound,
+    percent: limit.seconds / seconds,
+  };
+}
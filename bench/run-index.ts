@@ -0,0 +1,159 @@
+// index of every stored run
+// one entry per results file with per-(model, test) aggregates, kept in the
+// cache dir and refreshed by mtime + size so comparisons never re-parse runs
+// that haven't changed
+
+import { readdir, readFile, rename, stat, writeFile, mkdir } from "fs/promises";
+import { existsSync } from "fs";
+import { join } from "path";
+import { readResultsLog, resultKey } from "./results-log";
+import type { OptimizationResult } from "./optimization-runner";
+import { CACHE_DIRECTORY, OUTPUT_DIRECTORY } from "./constants";
+
+const INDEX_FILE = join(CACHE_DIRECTORY, "run-index.json");
+const INDEX_FORMAT = 1;
+
+export type PairStats = {
+  samples: number; // answered results for this (model, test); infra errors excluded
+  compiled: number;
+  correct: number;
+  speedups: number[]; // of the correct ones
+};
+
+export type IndexedRun = {
+  file: string; // relative to OUTPUT_DIRECTORY
+  suiteId: string;
+  version: string;
+  timestamp: string; // from the file name
+  mtimeMs: number;
+  size: number;
+  host?: string; // "<cpu model> @ <hostname>" from the summary's metadata.host
+  pairs: Record<string, PairStats>; // keyed by pairKey
+};
+
+type RunIndex = { format: number; runs: IndexedRun[] };
+
+export const pairKey = (model: string, testId: string) => `${model}\t${testId}`;
+
+export function splitPairKey(key: string): { model: string; testId: string } {
+  const [model, testId] = key.split("\t");
+  return { model, testId };
+}
+
+async function readIndex(): Promise<RunIndex> {
+  try {
+    const index = JSON.parse(await readFile(INDEX_FILE, "utf-8")) as RunIndex;
+    if (index.format === INDEX_FORMAT) return index;
+  } catch {}
+  return { format: INDEX_FORMAT, runs: [] };
+}
+
+async function readResults(file: string): Promise<OptimizationResult[]> {
+  if (file.endsWith(".ndjson")) return readResultsLog(file);
+  return (JSON.parse(await readFile(file, "utf-8")) as { results: OptimizationResult[] }).results;
+}
+
+async function readHost(versionDir: string, timestamp: string): Promise<string | undefined> {
+  try {
+    const summary = JSON.parse(await readFile(join(versionDir, `summary-${timestamp}.json`), "utf-8"));
+    const host = summary?.metadata?.host;
+    return host ? `${host.cpuModel} @ ${host.hostname}` : undefined;
+  } catch {
+    return undefined;
+  }
+}
+
+async function indexRun(
+  suiteId: string,
+  version: string,
+  file: string,
+  mtimeMs: number,
+  size: number
+): Promise<IndexedRun> {
+  const versionDir = join(OUTPUT_DIRECTORY, suiteId, version);
+  const timestamp = file.replace(/^results-/, "").replace(/\.(nd)?json$/, "");
+  // a resumed log can hold a failed request and its retry; the later one wins
+  const latest = new Map((await readResults(join(versionDir, file))).map((r) => [resultKey(r), r]));
+
+  const pairs: Record<string, PairStats> = {};
+  for (const r of latest.values()) {
+    if (r.infraError) continue;
+    const p = (pairs[pairKey(r.model, r.testId)] ??= { samples: 0, compiled: 0, correct: 0, speedups: [] });
+    p.samples++;
+    if (r.compiled) p.compiled++;
+    if (r.correct) {
+      p.correct++;
+      p.speedups.push(r.speedup);
+    }
+  }
+
+  return {
+    file: join(suiteId, version, file),
+    suiteId,
+    version,
+    timestamp,
+    mtimeMs,
+    size,
+    host: await readHost(versionDir, timestamp),
+    pairs,
+  };
+}
+
+// walks results/<suite>/<version>/results-*, re-reading only new or changed
+// files, and drops entries whose file is gone
+export async function updateRunIndex(): Promise<IndexedRun[]> {
+  const index = await readIndex();
+  const previous = new Map(index.runs.map((r) => [r.file, r]));
+  const runs: IndexedRun[] = [];
+  let changed = false;
+
+  if (existsSync(OUTPUT_DIRECTORY)) {
+    for (const suite of await readdir(OUTPUT_DIRECTORY, { withFileTypes: true })) {
+      if (!suite.isDirectory() || suite.name === "cache") continue;
+      const suiteDir = join(OUTPUT_DIRECTORY, suite.name);
+
+      for (const version of await readdir(suiteDir, { withFileTypes: true })) {
+        if (!version.isDirectory()) continue;
+        const versionDir = join(suiteDir, version.name);
+
+        for (const file of (await readdir(versionDir)).sort()) {
+          if (!file.startsWith("results-") || !(file.endsWith(".ndjson") || file.endsWith(".json"))) continue;
+          const info = await stat(join(versionDir, file));
+          const cached = previous.get(join(suite.name, version.name, file));
+          if (cached && cached.mtimeMs === info.mtimeMs && cached.size === info.size) {
+            runs.push(cached);
+            continue;
+          }
+          runs.push(await indexRun(suite.name, version.name, file, info.mtimeMs, info.size));
+          changed = true;
+        }
+      }
+    }
+  }
+
+  if (changed || runs.length !== index.runs.length) {
+    await mkdir(CACHE_DIRECTORY, { recursive: true });
+    // write then rename so a crash never leaves a half-written index
+    const tmp = `${INDEX_FILE}.${process.pid}.tmp`;
+    await writeFile(tmp, JSON.stringify({ format: INDEX_FORMAT, runs } satisfies RunIndex));
+    await rename(tmp, INDEX_FILE);
+  }
+  return runs;
+}
+
+// pools every run in `runs` into one PairStats per (model, test)
+export function mergePairs(runs: IndexedRun[]): Map<string, PairStats> {
+  const merged = new Map<string, PairStats>();
+  for (const run of runs) {
+    for (const [key, p] of Object.entries(run.pairs)) {
+      const m = merged.get(key) ?? { samples: 0, compiled: 0, correct: 0, speedups: [] };
+      merged.set(key, {
+        samples: m.samples + p.samples,
+        compiled: m.compiled + p.compiled,
+        correct: m.correct + p.correct,
+        speedups: [...m.speedups, ...p.speedups],
+      });
+    }
+  }
+  return merged;
+}
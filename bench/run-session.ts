@@ -0,0 +1,403 @@
+// benchmark session
+// everything a run does between picking a suite and writing its summary, with
+// progress reported as plain events. the ink tui and the headless runner are
+// both subscribers, so neither owns the orchestration
+
+import { join } from "path";
+import { readdir, readFile, writeFile, mkdir } from "fs/promises";
+import { existsSync } from "fs";
+import {
+  type OptimizationSuite,
+  type OptimizationResult,
+  type TestJob,
+} from "./optimization-runner";
+import { runPipeline, defaultPipelineConfig } from "./pipeline";
+import { leaderboardViews } from "./leaderboard";
+import { calibrate, hostFingerprint, type Calibration, type HostFingerprint } from "./calibration";
+import { rankedSpeedup } from "./footprint";
+import { connectWorkers } from "./worker-pool";
+import { checkDistinctModelKeys } from "./generation-cache";
+import { addToVariants, variantRankings, type VariantSummary } from "./prompt-variant";
+import {
+  addToSummary,
+  openResultsLog,
+  readResultsLog,
+  resultKey,
+  summaryRankings,
+  type SummaryTotals,
+} from "./results-log";
+import {
+  freeModels,
+  googleModels,
+  modelsToRun,
+  CALIBRATION_CONFIG,
+  DRY_RUN_CONFIG,
+  OUTPUT_DIRECTORY,
+  REFINE_CONFIG,
+  RESULTS_LOG_CONFIG,
+  TEST_RUNS_PER_MODEL,
+  TIMEOUT_SECONDS,
+  WORKER_CONFIG,
+  type RunnableModel,
+} from "./constants";
+
+// named model sets for --models, besides individual model names
+export const MODEL_SETS: Record<string, RunnableModel[]> = {
+  free: freeModels,
+  google: googleModels,
+  paid: modelsToRun,
+};
+const DEFAULT_MODEL_SETS = ["free", "google"];
+
+export type RunOptions = {
+  suiteId?: string; // required headless, picked interactively otherwise
+  version?: string; // defaults to today's date (or <replay>-replay)
+  models: RunnableModel[];
+  testIds?: string[]; // only these tests of the suite
+  variantIds?: string[]; // only these of the suite's prompt variants
+  samples: number[]; // sample indices to run
+  replayVersion?: string; // re-measure stored generations instead of asking models
+  reuseGenerations: boolean; // answer from the generation store when it holds the exact request
+  resume: boolean; // continue the latest results log of the version
+  dryRun: boolean;
+  workers?: string[]; // worker agent urls; compile, verify and measure run there
+};
+
+// --suite <id> --version <label> --models free,google,kimi-k2 --tests a,b
+// --variants a,b --samples 5 | 0-9 --replay <version> --reuse-generations --resume --dry-run
+// --workers http://bench1:7070,http://bench2:7070
+export function parseRunArgs(argv: string[]): RunOptions {
+  const value = (flag: string) => {
+    const i = argv.indexOf(flag);
+    return i >= 0 ? argv[i + 1] : undefined;
+  };
+  const list = (flag: string) => value(flag)?.split(",").map((s) => s.trim()).filter(Boolean);
+  const dryRun = argv.includes("--dry-run");
+
+  for (const set of Object.values(MODEL_SETS)) checkDistinctModelKeys(set);
+  const known = new Map<string, RunnableModel>();
+  for (const m of Object.values(MODEL_SETS).flat()) if (!known.has(m.name)) known.set(m.name, m);
+  const models: RunnableModel[] = [];
+  for (const name of list("--models") ?? DEFAULT_MODEL_SETS) {
+    const picked = MODEL_SETS[name] ?? (known.has(name) ? [known.get(name)!] : null);
+    if (!picked) throw new Error(`Unknown model or model set: ${name}`);
+    for (const m of picked) if (!models.includes(m)) models.push(m);
+  }
+  checkDistinctModelKeys(models);
+
+  // a count runs samples 0..n-1, a range picks a slice (to split a run across hosts)
+  const samplesArg = value("--samples");
+  const defaultCount = dryRun ? DRY_RUN_CONFIG.testRunsPerModel : TEST_RUNS_PER_MODEL;
+  const range = samplesArg?.match(/^(\d+)-(\d+)$/);
+  const samples = range
+    ? Array.from({ length: Math.max(0, Number(range[2]) - Number(range[1]) + 1) }, (_, i) => Number(range[1]) + i)
+    : Array.from({ length: samplesArg ? Number(samplesArg) : defaultCount }, (_, i) => i);
+
+  return {
+    suiteId: value("--suite"),
+    version: value("--version"),
+    models,
+    testIds: list("--tests"),
+    variantIds: list("--variants"),
+    samples,
+    replayVersion: value("--replay"),
+    reuseGenerations: argv.includes("--reuse-generations"),
+    resume: argv.includes("--resume"),
+    dryRun,
+    workers: list("--workers"),
+  };
+}
+
+export function defaultVersion(options: Pick<RunOptions, "replayVersion">) {
+  if (options.replayVersion) return `${options.replayVersion}-replay`;
+  const d = new Date();
+  return `${d.getFullYear()}-${String(d.getMonth() + 1).padStart(2, "0")}-${String(d.getDate()).padStart(2, "0")}`;
+}
+
+export async function findOptimSuites(testsDir: string) {
+  const entries = await readdir(testsDir, { withFileTypes: true });
+  const files = entries.filter((e) => e.isFile() && e.name.endsWith(".json"));
+  const suites: Array<{ filePath: string; suite: OptimizationSuite }> = [];
+
+  for (const f of files) {
+    try {
+      const filePath = join(testsDir, f.name);
+      const raw = await readFile(filePath, "utf-8");
+      const json = JSON.parse(raw);
+      // check if it's an optimization suite (has tests with 'code' field)
+      if (json?.tests?.[0]?.code) {
+        // a suite-level language applies to every test that doesn't set one
+        const suite = json as OptimizationSuite;
+        suite.tests = suite.tests.map((t) => ({ ...t, language: t.language ?? suite.language }));
+        suites.push({ filePath, suite });
+      }
+    } catch {}
+  }
+  return suites;
+}
+
+// results files of a version, oldest first; timestamps in the names sort.
+// runs from before the streaming log saved one results-<ts>.json
+async function resultsFiles(dir: string) {
+  if (!existsSync(dir)) return [];
+  return (await readdir(dir))
+    .filter((f) => f.startsWith("results-") && (f.endsWith(".ndjson") || f.endsWith(".json")))
+    .sort();
+}
+
+async function readResults(file: string): Promise<OptimizationResult[]> {
+  if (file.endsWith(".ndjson")) return readResultsLog(file);
+  return (JSON.parse(await readFile(file, "utf-8")) as { results: OptimizationResult[] }).results;
+}
+
+async function latestResultsLog(dir: string) {
+  const logs = (await resultsFiles(dir)).filter((f) => f.endsWith(".ndjson"));
+  const latest = logs[logs.length - 1];
+  return latest ? { timestamp: latest.slice("results-".length, -".ndjson".length) } : null;
+}
+
+// generation key per (model, test, sample) from every results file saved for
+// a version, later runs win
+async function loadReplayKeys(suiteId: string, version: string) {
+  const dir = join(OUTPUT_DIRECTORY, suiteId, version);
+  const keys = new Map<string, string>();
+  for (const f of await resultsFiles(dir)) {
+    for (const r of await readResults(join(dir, f))) {
+      if (r.generationKey) keys.set(resultKey(r), r.generationKey);
+    }
+  }
+  return keys;
+}
+
+export type RunEvent =
+  | { type: "start"; suiteId: string; version: string; outputDir: string; jobs: Record<string, number> } // per model, resumed included
+  | { type: "calibrated"; host: HostFingerprint; calibration?: Calibration }
+  | { type: "job"; model: string; testId: string; sample: number; variant?: string } // model request started
+  | {
+      type: "result";
+      model: string;
+      testId: string;
+      sample: number;
+      variant?: string;
+      resumed: boolean; // read back from the log of an interrupted run
+      result: OptimizationResult;
+    }
+  | { type: "done"; outputDir: string; summaryFile: string; summary: unknown };
+
+// runs one suite to completion; throws on setup errors (missing replay data)
+export async function runSession(
+  options: RunOptions,
+  suite: OptimizationSuite,
+  emit: (event: RunEvent) => void
+): Promise<void> {
+  const version = options.version ?? defaultVersion(options);
+  const { models, replayVersion } = options;
+  const tests = options.testIds ? suite.tests.filter((t) => options.testIds!.includes(t.id)) : suite.tests;
+  if (tests.length === 0) throw new Error(`No tests of ${suite.id} match ${options.testIds?.join(", ")}`);
+  const timeoutSeconds = options.dryRun ? DRY_RUN_CONFIG.timeoutSeconds : TIMEOUT_SECONDS;
+
+  const replayKeys = replayVersion ? await loadReplayKeys(suite.id, replayVersion) : null;
+  if (replayKeys && replayKeys.size === 0) {
+    throw new Error(`No stored generations for ${suite.id}/${replayVersion}`);
+  }
+
+  const outputDir = join(OUTPUT_DIRECTORY, suite.id, version);
+  if (!existsSync(outputDir)) {
+    await mkdir(outputDir, { recursive: true });
+  }
+
+  // --resume appends to the latest log for this version and skips
+  // whatever it already has
+  const previousLog = options.resume ? await latestResultsLog(outputDir) : null;
+  const timestamp = previousLog?.timestamp ?? new Date().toISOString().replace(/[:.]/g, "-");
+  const logFile = join(outputDir, `results-${timestamp}.ndjson`);
+  // failed requests are retried on resume
+  const previous = previousLog ? (await readResultsLog(logFile)).filter((r) => !r.infraError) : [];
+  const done = new Set(previous.map(resultKey));
+
+  const totals: SummaryTotals = new Map();
+  const variantTotals: VariantSummary = new Map();
+  for (const r of previous) {
+    addToSummary(totals, r);
+    addToVariants(variantTotals, r);
+  }
+
+  // every (model, test, sample) goes through the staged pipeline; model
+  // requests, compiles and timed runs each have their own limits.
+  // sample-major order, so an interrupted run still covers every pair.
+  // a replay only has the tuples that were stored. prompt variants are one
+  // more axis, innermost so every variant of a pair runs close together
+  const declared = (suite.promptVariants ?? []).filter((v) => !options.variantIds || options.variantIds.includes(v.id));
+  if (suite.promptVariants?.length && declared.length === 0) {
+    throw new Error(`No prompt variants of ${suite.id} match ${options.variantIds?.join(", ")}`);
+  }
+  const variants = declared.length > 0 ? declared : [undefined];
+  const jobs: TestJob[] = options.samples.flatMap((sample) =>
+    tests.flatMap((test) =>
+      models.flatMap((model) =>
+        variants.flatMap((variant) => {
+          const key = resultKey({ model: model.name, testId: test.id, sample, variant: variant?.id });
+          const replay = replayKeys?.get(key);
+          if ((replayKeys && !replay) || done.has(key)) return [];
+          return [{
+            model,
+            test,
+            systemPrompt: suite.systemPrompt,
+            timeoutMs: timeoutSeconds * 1000,
+            sample,
+            variant,
+            replay,
+            reuseGenerations: options.reuseGenerations,
+            silent: true,
+          }];
+        })
+      )
+    )
+  );
+
+  const perModel = Object.fromEntries(models.map((m) => [m.name, 0]));
+  for (const j of jobs) perModel[j.model.name]++;
+  for (const r of previous) if (r.model in perModel) perModel[r.model]++;
+  emit({ type: "start", suiteId: suite.id, version, outputDir, jobs: perModel });
+  for (const r of previous) {
+    emit({ type: "result", model: r.model, testId: r.testId, sample: r.sample ?? 0, variant: r.variant, resumed: true, result: r });
+  }
+
+  // distributed: the workers measure, so theirs are the host and noise floor
+  // that count (they are meant to be identical; each result names its worker)
+  const token = process.env[WORKER_CONFIG.tokenEnv] ?? "";
+  const pool = options.workers?.length
+    ? await connectWorkers(options.workers, token, REFINE_CONFIG.rounds, WORKER_CONFIG)
+    : undefined;
+
+  // noise floor of this host before anything else competes for it; the
+  // runner flags results with the same numbers
+  const calibration = pool ? pool.workers[0].info.calibration : await calibrate(CALIBRATION_CONFIG);
+  const host = pool ? pool.workers[0].info.host : hostFingerprint();
+  emit({ type: "calibrated", host, calibration });
+
+  const log = openResultsLog(logFile, RESULTS_LOG_CONFIG);
+  const pipelineConfig = defaultPipelineConfig();
+  pipelineConfig.workers = pool;
+  if (options.dryRun) {
+    pipelineConfig.concurrency.generate = DRY_RUN_CONFIG.maxConcurrency;
+    pipelineConfig.staggerDelayMs = DRY_RUN_CONFIG.staggerDelayMs;
+  }
+  await runPipeline(jobs, pipelineConfig, {
+    onStageStart: (stage, job) => {
+      if (stage !== "generate") return;
+      emit({ type: "job", model: job.model.name, testId: job.test.id, sample: job.sample ?? 0, variant: job.variant?.id });
+    },
+    onResult: (result, job) => {
+      log.append(result);
+      addToSummary(totals, result);
+      addToVariants(variantTotals, result);
+      emit({
+        type: "result",
+        model: job.model.name,
+        testId: job.test.id,
+        sample: job.sample ?? 0,
+        variant: job.variant?.id,
+        resumed: false,
+        result,
+      });
+    },
+  });
+  log.close();
+
+  // summary for the visualizer
+  const rankings = summaryRankings(totals, models.map((m) => m.name));
+  const summary = {
+    rankings,
+    // speedup vs cost / latency fronts and reasoning variants side by side
+    ...leaderboardViews(rankings, models),
+    // same models under each prompt variant, with tokens and latency per answer
+    promptVariants: declared.length > 0 ? variantRankings(variantTotals, declared) : undefined,
+    metadata: {
+      timestamp: new Date().toISOString(),
+      testSuite: suite.name,
+      suiteId: suite.id,
+      version,
+      replayOf: replayVersion,
+      totalModels: models.length,
+      totalTests: tests.length,
+      samplesPerTest: options.samples.length,
+      promptVariantIds: declared.length > 0 ? declared.map((v) => v.id) : undefined,
+      host,
+      calibration,
+      workers: pool?.workers.map((w) => ({ url: w.url, fingerprint: w.info.fingerprint, host: w.info.host })),
+    },
+  };
+
+  const summaryFile = join(outputDir, `summary-${timestamp}.json`);
+  await writeFile(summaryFile, JSON.stringify(summary, null, 2));
+
+  emit({ type: "done", outputDir, summaryFile, summary });
+}
+
+export type ModelStats = {
+  testsRun: number;
+  testsTotal: number;
+  infraErrors: number; // counted in testsRun only for progress
+  compiled: number;
+  correct: number;
+  logSpeedupSum: number; // failures count as 1x, like the summary's geomean
+  geomeanSpeedup: number;
+  costUsd: number;
+  running: boolean;
+};
+
+export function applyResult(s: ModelStats, result: OptimizationResult): ModelStats {
+  const testsRun = s.testsRun + 1;
+  if (result.infraError) {
+    return { ...s, testsRun, infraErrors: s.infraErrors + 1, running: testsRun < s.testsTotal };
+  }
+  const speedup = rankedSpeedup(result);
+  const logSpeedupSum = s.logSpeedupSum + (speedup > 0 ? Math.log(speedup) : 0);
+  const scored = testsRun - s.infraErrors;
+  return {
+    ...s,
+    testsRun,
+    compiled: s.compiled + (result.compiled ? 1 : 0),
+    correct: s.correct + (result.correct ? 1 : 0),
+    logSpeedupSum,
+    geomeanSpeedup: Math.exp(logSpeedupSum / scored),
+    costUsd: s.costUsd + (result.generationCached ? 0 : result.costUsd ?? 0),
+    running: testsRun < s.testsTotal,
+  };
+}
+
+// folds the event stream into per-model counters; subscribers read `stats`
+// whenever they like instead of redrawing on every event
+export function progressTracker() {
+  const stats: Record<string, ModelStats> = {};
+  let current = "";
+  return {
+    stats,
+    current: () => current,
+    total: () => Object.values(stats).reduce((sum, s) => sum + s.testsTotal, 0),
+    completed: () => Object.values(stats).reduce((sum, s) => sum + s.testsRun, 0),
+    apply(event: RunEvent) {
+      if (event.type === "start") {
+        for (const [model, testsTotal] of Object.entries(event.jobs)) {
+          stats[model] = {
+            testsRun: 0,
+            testsTotal,
+            infraErrors: 0,
+            compiled: 0,
+            correct: 0,
+            logSpeedupSum: 0,
+            geomeanSpeedup: 0,
+            costUsd: 0,
+            running: false,
+          };
+        }
+      } else if (event.type === "job") {
+        current = `${event.model} / ${event.testId} #${event.sample}${event.variant ? ` [${event.variant}]` : ""}`;
+        if (stats[event.model]) stats[event.model] = { ...stats[event.model], running: true };
+      } else if (event.type === "result" && stats[event.model]) {
+        stats[event.model] = applyResult(stats[event.model], event.result);
+      }
+    },
+  };
+}
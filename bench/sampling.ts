@@ -0,0 +1,116 @@
+// timing statistics and adaptive sampling
+// warmup runs are thrown away, then we keep sampling until the bootstrap CI
+// on the median is tight enough or the time budget runs out
+
+export type SamplingConfig = {
+  warmupRuns: number; // batches discarded before sampling
+  minSamples: number;
+  maxSamples: number;
+  targetRelativeCI: number; // stop once (ciHigh - ciLow) / 2 / median is below this
+  timeBudgetMs: number; // wall-clock cap per measurement
+};
+
+export type SampleStats = {
+  n: number;
+  median: number;
+  mean: number;
+  stddev: number;
+  mad: number; // median absolute deviation
+  ciLow: number; // 95% bootstrap CI on the median
+  ciHigh: number;
+};
+
+const BOOTSTRAP_RESAMPLES = 1000;
+
+export function median(values: number[]): number {
+  if (values.length === 0) return 0;
+  const sorted = [...values].sort((a, b) => a - b);
+  const mid = Math.floor(sorted.length / 2);
+  return sorted.length % 2 === 0 ? (sorted[mid - 1] + sorted[mid]) / 2 : sorted[mid];
+}
+
+// small seeded prng so bootstrap intervals are reproducible
+function mulberry32(seed: number) {
+  return () => {
+    seed = (seed + 0x6d2b79f5) | 0;
+    let t = Math.imul(seed ^ (seed >>> 15), 1 | seed);
+    t = (t + Math.imul(t ^ (t >>> 7), 61 | t)) ^ t;
+    return ((t ^ (t >>> 14)) >>> 0) / 4294967296;
+  };
+}
+
+function resample(values: number[], rand: () => number): number[] {
+  const out = new Array<number>(values.length);
+  for (let i = 0; i < values.length; i++) {
+    out[i] = values[Math.floor(rand() * values.length)];
+  }
+  return out;
+}
+
+function percentileInterval(estimates: number[]): [number, number] {
+  estimates.sort((a, b) => a - b);
+  const lo = estimates[Math.floor(estimates.length * 0.025)];
+  const hi = estimates[Math.min(estimates.length - 1, Math.floor(estimates.length * 0.975))];
+  return [lo, hi];
+}
+
+export function summarize(samples: number[]): SampleStats {
+  const n = samples.length;
+  if (n === 0) return { n: 0, median: 0, mean: 0, stddev: 0, mad: 0, ciLow: 0, ciHigh: 0 };
+
+  const med = median(samples);
+  const mean = samples.reduce((s, x) => s + x, 0) / n;
+  const variance = n > 1 ? samples.reduce((s, x) => s + (x - mean) ** 2, 0) / (n - 1) : 0;
+  const mad = median(samples.map((x) => Math.abs(x - med)));
+
+  const rand = mulberry32(n);
+  const medians: number[] = [];
+  for (let i = 0; i < BOOTSTRAP_RESAMPLES; i++) medians.push(median(resample(samples, rand)));
+  const [ciLow, ciHigh] = percentileInterval(medians);
+
+  return { n, median: med, mean, stddev: Math.sqrt(variance), mad, ciLow, ciHigh };
+}
+
+// 95% bootstrap CI for median(baseline) / median(optimized)
+export function speedupInterval(baseline: number[], optimized: number[]): [number, number] {
+  if (baseline.length === 0 || optimized.length === 0) return [0, 0];
+  const rand = mulberry32(baseline.length * 31 + optimized.length);
+  const ratios: number[] = [];
+  for (let i = 0; i < BOOTSTRAP_RESAMPLES; i++) {
+    const o = median(resample(optimized, rand));
+    ratios.push(o > 0 ? median(resample(baseline, rand)) / o : 0);
+  }
+  return percentileInterval(ratios);
+}
+
+function relativeCI(stats: SampleStats) {
+  return stats.median > 0 ? (stats.ciHigh - stats.ciLow) / 2 / stats.median : Infinity;
+}
+
+// collect() returns one batch of samples (a single process run, or every
+// iteration of one harness invocation); batches are repeated until converged
+export async function sampleAdaptive(
+  collect: () => Promise<{ samples: number[]; error?: string }>,
+  config: SamplingConfig
+): Promise<{ samples: number[]; stats: SampleStats; error?: string }> {
+  const start = performance.now();
+
+  for (let i = 0; i < config.warmupRuns; i++) {
+    const warm = await collect();
+    if (warm.error) return { samples: [], stats: summarize([]), error: warm.error };
+  }
+
+  const samples: number[] = [];
+  while (samples.length < config.maxSamples) {
+    const batch = await collect();
+    if (batch.error) return { samples: [], stats: summarize([]), error: batch.error };
+    if (batch.samples.length === 0) return { samples: [], stats: summarize([]), error: "No samples collected" };
+    samples.push(...batch.samples);
+
+    if (samples.length < config.minSamples) continue;
+    if (performance.now() - start > config.timeBudgetMs) break;
+    if (relativeCI(summarize(samples)) <= config.targetRelativeCI) break;
+  }
+
+  return { samples, stats: summarize(samples) };
+}
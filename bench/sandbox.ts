@@ -0,0 +1,168 @@
+// sandboxed execution of model-written binaries
+// a small C wrapper (built once through the compile farm) applies rlimits,
+// no_new_privs and an optional private network namespace, then reports the
+// child's rusage from wait4 and its wall time from exec to exit on fd 3
+
+import { farmBuild } from "./compile-farm";
+import type { Toolchain } from "./toolchain";
+
+export type SandboxConfig = {
+  enabled: boolean;
+  addressSpaceMb: number; // RLIMIT_AS, 0 = unlimited
+  cpuSeconds: number; // RLIMIT_CPU, 0 = unlimited
+  fileSizeMb: number; // RLIMIT_FSIZE, caps every file the program writes
+  isolateNetwork: boolean; // unshare(CLONE_NEWNET), best effort
+};
+
+export type ResourceUsage = {
+  maxRssKb: number;
+  minorFaults: number;
+  majorFaults: number;
+  voluntaryCtxSwitches: number;
+  involuntaryCtxSwitches: number;
+  userMs: number;
+  sysMs: number;
+  wallMs: number; // exec to wait4, without the wrapper's own fork and setup
+};
+
+const SANDBOX_SOURCE = `#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+static pid_t child = -1;
+
+static void forward(int sig) {
+    (void)sig;
+    if (child > 0) kill(child, SIGKILL);
+}
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void limit(int resource, rlim_t value) {
+    struct rlimit r = { value, value };
+    setrlimit(resource, &r);
+}
+
+// usage: sandbox <as-mb> <cpu-s> <fsize-mb> <isolate-net> -- cmd [args...]
+int main(int argc, char **argv) {
+    if (argc < 7 || strcmp(argv[5], "--") != 0) {
+        fprintf(stderr, "usage: %s <as-mb> <cpu-s> <fsize-mb> <isolate-net> -- cmd [args...]\\n", argv[0]);
+        return 125;
+    }
+    long as_mb = atol(argv[1]), cpu_s = atol(argv[2]), fsize_mb = atol(argv[3]);
+    int isolate_net = atoi(argv[4]);
+    fcntl(3, F_SETFD, FD_CLOEXEC);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof sa);
+    sa.sa_handler = forward;
+    sigaction(SIGTERM, &sa, NULL);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGHUP, &sa, NULL);
+
+    // the child stamps the time right before exec, so rlimits and unshare
+    // stay outside the measured interval
+    volatile long long *exec_ns = mmap(NULL, sizeof *exec_ns, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (exec_ns == MAP_FAILED) exec_ns = NULL;
+    long long fork_ns = now_ns();
+    child = fork();
+    if (child < 0) {
+        perror("fork");
+        return 125;
+    }
+    if (child == 0) {
+        prctl(PR_SET_PDEATHSIG, SIGKILL);
+        if (as_mb > 0) limit(RLIMIT_AS, (rlim_t)as_mb << 20);
+        if (cpu_s > 0) limit(RLIMIT_CPU, (rlim_t)cpu_s);
+        if (fsize_mb >= 0) limit(RLIMIT_FSIZE, (rlim_t)fsize_mb << 20);
+        limit(RLIMIT_CORE, 0);
+        prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0);
+        if (isolate_net && unshare(CLONE_NEWNET) != 0) unshare(CLONE_NEWUSER | CLONE_NEWNET);
+        if (exec_ns) *exec_ns = now_ns();
+        execvp(argv[6], argv + 6);
+        perror("execvp");
+        _exit(127);
+    }
+
+    int status;
+    struct rusage ru;
+    while (wait4(child, &status, 0, &ru) < 0) {
+        if (errno != EINTR) {
+            perror("wait4");
+            return 125;
+        }
+    }
+    long long end_ns = now_ns();
+    long long start_ns = exec_ns && *exec_ns > 0 ? *exec_ns : fork_ns;
+    dprintf(3, "%ld %ld %ld %ld %ld %ld %ld %lld\\n", ru.ru_maxrss, ru.ru_minflt, ru.ru_majflt, ru.ru_nvcsw,
+            ru.ru_nivcsw, ru.ru_utime.tv_sec * 1000000L + ru.ru_utime.tv_usec,
+            ru.ru_stime.tv_sec * 1000000L + ru.ru_stime.tv_usec, end_ns - start_ns);
+
+    if (WIFSIGNALED(status)) {
+        int sig = WTERMSIG(status);
+        fprintf(stderr, "killed by signal %d (%s)%s\\n", sig, strsignal(sig),
+                sig == SIGXCPU ? ": cpu limit exceeded" : sig == SIGXFSZ ? ": file size limit exceeded" : "");
+        return 128 + sig;
+    }
+    return WEXITSTATUS(status);
+}
+`;
+
+const HELPER_TOOLCHAIN: Toolchain = { id: "sandbox", compiler: "cc", flags: ["-O2"] };
+
+let helper: Promise<string | null> | null = null;
+
+// path of the wrapper binary, or null if it couldn't be built
+export function sandboxHelper(): Promise<string | null> {
+  if (!helper) {
+    helper = farmBuild(HELPER_TOOLCHAIN, SANDBOX_SOURCE).then((build) => {
+      if (!build.success) console.warn(`sandbox helper failed to build, running unsandboxed: ${build.error}`);
+      return build.success ? build.binary : null;
+    });
+  }
+  return helper;
+}
+
+export function sandboxArgs(config: SandboxConfig, cmd: string, args: string[]): string[] {
+  return [
+    String(config.addressSpaceMb),
+    String(config.cpuSeconds),
+    String(config.fileSizeMb),
+    config.isolateNetwork ? "1" : "0",
+    "--",
+    cmd,
+    ...args,
+  ];
+}
+
+// the wrapper's fd 3 line: maxrss_kb minflt majflt nvcsw nivcsw utime_us stime_us wall_ns
+export function parseResourceUsage(line: string): ResourceUsage | undefined {
+  const fields = line.trim().split(/\s+/).map(Number);
+  if (fields.length < 8 || fields.some((n) => !Number.isFinite(n))) return undefined;
+  const [maxRssKb, minorFaults, majorFaults, voluntaryCtxSwitches, involuntaryCtxSwitches, userUs, sysUs, wallNs] = fields;
+  return {
+    maxRssKb,
+    minorFaults,
+    majorFaults,
+    voluntaryCtxSwitches,
+    involuntaryCtxSwitches,
+    userMs: userUs / 1000,
+    sysMs: sysUs / 1000,
+    wallMs: wallNs / 1e6,
+  };
+}
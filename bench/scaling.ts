@@ -0,0 +1,66 @@
+// input-size sweeps and empirical scaling exponents
+// a test can declare a size macro and a set of values; baseline and candidate
+// are rebuilt with -D (or fed the size on stdin) for each one and the log-log
+// slope of time vs size is fit
+
+export type ParamSweep = {
+  define: string; // macro that sets the problem size, guarded by #ifndef in the code
+  values: number[];
+  via?: "define" | "stdin"; // stdin = the program reads the size at runtime, so it can't be folded
+};
+
+export type SweepPoint = {
+  value: number;
+  baselineTimeMs: number;
+  optimizedTimeMs: number;
+  speedup: number;
+  correct: boolean; // candidate output matches the baseline at this size
+  error?: string;
+};
+
+export type ScalingResult = {
+  param: string;
+  points: SweepPoint[];
+  baselineExponent?: number; // t ~ n^k, least squares on log t vs log n
+  optimizedExponent?: number;
+  constantTime?: boolean; // baseline grows with size but the candidate doesn't: likely precomputed
+};
+
+export function sweepFlags(sweep: ParamSweep, value: number): string[] {
+  return sweep.via === "stdin" ? [] : [`-D${sweep.define}=${value}`];
+}
+
+export function sweepInput(sweep: ParamSweep, value: number): string | undefined {
+  return sweep.via === "stdin" ? `${value}\n` : undefined;
+}
+
+// the baseline gets at least 4x slower across the sweep while the candidate
+// stays within 25%. usually a precomputed answer; a genuine closed form trips
+// it too, so it is a flag rather than a failure
+export function looksConstantTime(points: SweepPoint[]): boolean {
+  const ok = points
+    .filter((p) => p.correct && p.baselineTimeMs > 0 && !p.error)
+    .sort((a, b) => a.value - b.value);
+  if (ok.length < 2) return false;
+  const first = ok[0];
+  const last = ok[ok.length - 1];
+  // 1ns floor: a folded kernel can time as exactly 0
+  const growth = (last.optimizedTimeMs + 1e-6) / (first.optimizedTimeMs + 1e-6);
+  return last.baselineTimeMs / first.baselineTimeMs >= 4 && growth < 1.25;
+}
+
+// slope of log(time) over log(size); needs two distinct positive points
+export function fitScalingExponent(points: Array<[size: number, timeMs: number]>): number | undefined {
+  const logs = points.filter(([n, t]) => n > 0 && t > 0).map(([n, t]) => [Math.log(n), Math.log(t)]);
+  if (logs.length < 2) return undefined;
+
+  const meanX = logs.reduce((s, [x]) => s + x, 0) / logs.length;
+  const meanY = logs.reduce((s, [, y]) => s + y, 0) / logs.length;
+  let sxy = 0;
+  let sxx = 0;
+  for (const [x, y] of logs) {
+    sxy += (x - meanX) * (y - meanY);
+    sxx += (x - meanX) ** 2;
+  }
+  return sxx > 0 ? sxy / sxx : undefined;
+}
@@ -0,0 +1,161 @@
+// affinity-aware scheduler for timed runs
+// timed execution is exclusive: one run per physical core, pinned with taskset,
+// while gcc and the runner itself are kept off those cores. llm requests are
+// i/o bound and don't go through here at all
+
+import { readFileSync, readdirSync, existsSync } from "fs";
+import { execFileSync } from "child_process";
+import { cpus } from "os";
+
+export type SchedulerConfig = {
+  timingCpus: number[] | null; // null = kernel isolcpus, else every physical core but the first
+  excludeSmtSiblings: boolean; // keep the siblings of timing cores idle too
+};
+
+export type TimedScheduler = {
+  timingCpus: number[]; // one logical cpu per timing slot
+  compileCpus: number[] | null; // where everything else may run (null = anywhere)
+  runTimed<T>(fn: (cpu: number | null) => Promise<T>): Promise<T>;
+  // several timing cores at once, for multi-threaded runs (capped at timingCpus.length)
+  runTimedMany<T>(count: number, fn: (cpus: number[] | null) => Promise<T>): Promise<T>;
+};
+
+// "0-3,8,10-11" -> [0, 1, 2, 3, 8, 10, 11]
+export function parseCpuList(list: string): number[] {
+  const out: number[] = [];
+  for (const part of list.trim().split(",")) {
+    if (!part) continue;
+    const [lo, hi] = part.split("-").map(Number);
+    for (let c = lo; c <= (hi ?? lo); c++) out.push(c);
+  }
+  return out;
+}
+
+export function readSys(path: string): string | null {
+  try {
+    return readFileSync(path, "utf-8").trim();
+  } catch {
+    return null;
+  }
+}
+
+// logical cpus grouped by physical core, lowest cpu first
+export function readCpuTopology(): number[][] {
+  const base = "/sys/devices/system/cpu";
+  const seen = new Map<string, number[]>();
+
+  if (existsSync(base)) {
+    for (const entry of readdirSync(base)) {
+      if (!/^cpu\d+$/.test(entry)) continue;
+      const siblings = readSys(`${base}/${entry}/topology/thread_siblings_list`);
+      if (siblings && !seen.has(siblings)) seen.set(siblings, parseCpuList(siblings));
+    }
+  }
+
+  if (seen.size === 0) {
+    // no sysfs (or a locked-down container): treat every cpu as its own core
+    return cpus().map((_, i) => [i]);
+  }
+  return [...seen.values()].sort((a, b) => a[0] - b[0]);
+}
+
+let hasTaskset: boolean | null = null;
+
+export function tasksetAvailable(): boolean {
+  if (hasTaskset === null) {
+    try {
+      execFileSync("taskset", ["-p", String(process.pid)], { stdio: "ignore" });
+      hasTaskset = true;
+    } catch {
+      hasTaskset = false;
+    }
+  }
+  return hasTaskset;
+}
+
+// wraps a command so it runs on the given cpus
+export function pinnedCommand(
+  cmd: string,
+  args: string[],
+  cpuList: number[] | null
+): { cmd: string; args: string[] } {
+  if (!cpuList || cpuList.length === 0 || !tasksetAvailable()) return { cmd, args };
+  return { cmd: "taskset", args: ["-c", cpuList.join(","), cmd, ...args] };
+}
+
+export function createTimedScheduler(config: SchedulerConfig): TimedScheduler {
+  const cores = readCpuTopology();
+  const allCpus = cores.flat();
+
+  let timingCores: number[][];
+  const isolated = parseCpuList(readSys("/sys/devices/system/cpu/isolated") ?? "");
+  const wanted = config.timingCpus ?? (isolated.length > 0 ? isolated : null);
+  if (wanted) {
+    timingCores = cores.filter((core) => core.some((c) => wanted.includes(c)));
+  } else {
+    // leave the first core to the runner, gcc and the os
+    timingCores = cores.length > 1 ? cores.slice(1) : cores;
+  }
+  if (timingCores.length === 0) timingCores = [cores[0]];
+
+  const timingCpus = timingCores.map((core) => (wanted ? core.find((c) => wanted.includes(c))! : core[0]));
+  const reserved = new Set(config.excludeSmtSiblings ? timingCores.flat() : timingCpus);
+  const rest = allCpus.filter((c) => !reserved.has(c));
+  const compileCpus = rest.length > 0 ? rest : null;
+
+  // move the runner itself (and its threads) off the timing cores
+  if (compileCpus && tasksetAvailable()) {
+    try {
+      execFileSync("taskset", ["-a", "-p", "-c", compileCpus.join(","), String(process.pid)], {
+        stdio: "ignore",
+      });
+    } catch {}
+  }
+
+  // waiters are served in order, so a wide request isn't starved by narrow ones
+  let free = [...timingCpus];
+  const waiters: Array<{ count: number; resolve: (cpus: number[]) => void }> = [];
+  const pinning = tasksetAvailable();
+
+  const serve = () => {
+    while (waiters.length > 0 && waiters[0].count <= free.length) {
+      const { count, resolve } = waiters.shift()!;
+      resolve(free.splice(0, count));
+    }
+  };
+
+  const acquire = (count: number) =>
+    new Promise<number[]>((resolve) => {
+      waiters.push({ count: Math.max(1, Math.min(count, timingCpus.length)), resolve });
+      serve();
+    });
+
+  const release = (cpus: number[]) => {
+    // keep timing config order so multi-core grants stay on neighbouring cores
+    free = timingCpus.filter((c) => free.includes(c) || cpus.includes(c));
+    serve();
+  };
+
+  const runTimedMany = async <T>(count: number, fn: (cpus: number[] | null) => Promise<T>): Promise<T> => {
+    const cpus = await acquire(count);
+    try {
+      return await fn(pinning ? cpus : null);
+    } finally {
+      release(cpus);
+    }
+  };
+
+  return {
+    timingCpus,
+    compileCpus,
+    runTimed: (fn) => runTimedMany(1, (cpus) => fn(cpus ? cpus[0] : null)),
+    runTimedMany,
+  };
+}
+
+let defaultScheduler: TimedScheduler | null = null;
+
+export function getTimedScheduler(config: SchedulerConfig): TimedScheduler {
+  if (!defaultScheduler) defaultScheduler = createTimedScheduler(config);
+  return defaultScheduler;
+}
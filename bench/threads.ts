@@ -0,0 +1,37 @@
+// thread-scaling track
+// tests that opt in are built with -fopenmp -pthread; the candidate is timed at
+// 1, 2, 4, ... threads, each run pinned to that many exclusive timing cores
+
+export type ThreadSpec = {
+  counts?: number[]; // default: powers of two up to the timing cores, plus the max
+};
+
+export type ThreadPoint = {
+  threads: number;
+  timeMs: number;
+  speedup: number; // baseline (single-threaded) / this run
+  efficiency: number; // strong scaling: t1 / (threads * tN)
+  correct: boolean;
+  error?: string;
+};
+
+export type ThreadScaling = {
+  singleThreadSpeedup: number;
+  points: ThreadPoint[];
+  maxThreads: number;
+  efficiencyAtMax?: number;
+};
+
+export function threadCounts(spec: ThreadSpec, available: number): number[] {
+  const wanted = spec.counts ?? [];
+  if (wanted.length === 0) {
+    for (let t = 1; t < available; t *= 2) wanted.push(t);
+    wanted.push(available);
+  }
+  return [...new Set(wanted.filter((t) => t >= 1 && t <= available))].sort((a, b) => a - b);
+}
+
+// openmp reads these; pthreads code is asked to size its pool from OMP_NUM_THREADS too
+export function threadEnv(threads: number): Record<string, string> {
+  return { OMP_NUM_THREADS: String(threads), OMP_PROC_BIND: "close", OMP_PLACES: "cores" };
+}
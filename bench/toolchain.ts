@@ -0,0 +1,124 @@
+// compiler/flag matrix
+// baseline and candidate are both built with every configured toolchain, and
+// each candidate build is compared against the baseline from the same one
+
+import { mkdir, readdir, rm } from "fs/promises";
+import { join } from "path";
+import { runCommand } from "./command";
+import { compilerVersion } from "./baseline-cache";
+import { getTimedScheduler } from "./scheduler";
+import { SANDBOX_CONFIG, SCHEDULER_CONFIG } from "./constants";
+
+export type Toolchain = {
+  id: string; // e.g. "gcc-O3-native", used in result keys and file names
+  compiler: string;
+  flags: string[];
+  pgo?: boolean; // instrumented build, one training run, rebuild with the profile
+};
+
+export type BuildResult = { success: boolean; error?: string; compileMs?: number }; // compiler wall time
+
+export type Language = "c" | "cpp";
+
+export const CXX_STANDARD = "-std=c++20";
+
+const isCxx = (compiler: string) => /\+\+/.test(compiler);
+
+// the same configuration for c++ sources: gcc -> g++, clang-18 -> clang++-18
+export function forLanguage(tc: Toolchain, language: Language = "c"): Toolchain {
+  if (language === "c" || isCxx(tc.compiler)) return tc;
+  const compiler = tc.compiler.replace(/(gcc|clang)(-[\d.]+)?$/, (_, cc: string, version = "") =>
+    `${cc === "gcc" ? "g++" : "clang++"}${version}`
+  );
+  return { ...tc, compiler, flags: [CXX_STANDARD, ...tc.flags] };
+}
+
+// the driver picks the language from the extension
+export function sourceFileName(tc: Toolchain): string {
+  return isCxx(tc.compiler) ? "main.cpp" : "main.c";
+}
+
+// compiles one source file into an executable
+export async function compileC(
+  sourceFile: string,
+  outputFile: string,
+  flags: string[] = [],
+  compiler = "gcc"
+): Promise<BuildResult> {
+  const start = performance.now();
+  const result = await runCommand(
+    compiler,
+    [
+      ...flags,
+      "-o",
+      outputFile,
+      sourceFile,
+      "-lm", // link math library
+    ],
+    { cpus: getTimedScheduler(SCHEDULER_CONFIG).compileCpus }
+  );
+
+  const compileMs = performance.now() - start;
+  if (result.exitCode !== 0) {
+    return { success: false, error: result.stderr, compileMs };
+  }
+  return { success: true, compileMs };
+}
+
+const isClang = (compiler: string) => /clang/.test(compiler);
+
+// clang-17 writes profiles only llvm-profdata-17 reads, so keep the suffix
+// (and any directory): /usr/bin/clang++-17 -> /usr/bin/llvm-profdata-17
+export const profdataFor = (compiler: string) => compiler.replace(/clang(\+\+)?(?=(-[\d.]+)?$)/, "llvm-profdata");
+
+// drops toolchains whose compiler isn't installed, keeping config order
+export function availableToolchains(toolchains: Toolchain[]): Toolchain[] {
+  return toolchains.filter((tc) => compilerVersion(tc.compiler) !== "unknown");
+}
+
+export async function buildWithToolchain(
+  tc: Toolchain,
+  sourceFile: string,
+  outputFile: string,
+  extraFlags: string[] = [],
+  trainingInput?: string // stdin of the pgo training run, what the binary will be timed with
+): Promise<BuildResult> {
+  const flags = [...tc.flags, ...extraFlags];
+  if (!tc.pgo) return compileC(sourceFile, outputFile, flags, tc.compiler);
+
+  const profileDir = `${outputFile}.profile`;
+  await rm(profileDir, { recursive: true, force: true });
+  await mkdir(profileDir, { recursive: true });
+
+  const genFlags = isClang(tc.compiler)
+    ? [`-fprofile-instr-generate=${join(profileDir, "default.profraw")}`]
+    : [`-fprofile-generate=${profileDir}`];
+  const instrumented = await compileC(sourceFile, outputFile, [...flags, ...genFlags], tc.compiler);
+  if (!instrumented.success) return instrumented;
+
+  const training = await runCommand(outputFile, [], {
+    timeout: 120000,
+    input: trainingInput,
+    cpus: getTimedScheduler(SCHEDULER_CONFIG).compileCpus,
+    sandbox: SANDBOX_CONFIG,
+  });
+  if (training.exitCode !== 0) {
+    return { success: false, error: `PGO training run failed: ${training.stderr || "Runtime error"}` };
+  }
+
+  let useFlags: string[];
+  if (isClang(tc.compiler)) {
+    const profdata = join(profileDir, "merged.profdata");
+    const raw = (await readdir(profileDir)).filter((f) => f.endsWith(".profraw")).map((f) => join(profileDir, f));
+    const profdataTool = profdataFor(tc.compiler);
+    const merge = await runCommand(profdataTool, ["merge", "-o", profdata, ...raw]);
+    if (merge.exitCode !== 0) return { success: false, error: `${profdataTool} merge failed: ${merge.stderr}` };
+    useFlags = [`-fprofile-instr-use=${profdata}`];
+  } else {
+    useFlags = [`-fprofile-use=${profileDir}`, "-fprofile-correction", "-Wno-missing-profile"];
+  }
+
+  // the training run isn't compile time
+  const final = await compileC(sourceFile, outputFile, [...flags, ...useFlags], tc.compiler);
+  return { ...final, compileMs: (instrumented.compileMs ?? 0) + (final.compileMs ?? 0) };
+}
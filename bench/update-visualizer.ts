@@ -1,12 +1,22 @@
 #!/usr/bin/env bun
-// copies the latest summary.json and results.json to the visualizer data directory
+// copies the latest summary.json to the visualizer data directory and splits its
+// results (the streaming results-<ts>.ndjson log on newer runs) into a compact
+// index plus per-(model, test) shards, plus the trend series over every stored
+// run of that suite
 
 import { readdir, readFile, writeFile, stat } from "fs/promises";
 import { join, dirname } from "path";
+import { readResultsLog, resultKey } from "./results-log";
+import { updateRunIndex } from "./run-index";
+import { trendSeries } from "./regression";
+import { writeDetailShards } from "./detail-shards";
+import type { OptimizationResult } from "./optimization-runner";
 
 const RESULTS_DIR = "./results";
 const VISUALIZER_DATA = "../visualizer/data/benchmark-results.json";
 const VISUALIZER_DETAILS = "../visualizer/data/benchmark-details.json";
+const VISUALIZER_SHARDS = "../visualizer/public/details"; // served as /details/<shard>.json
+const VISUALIZER_TRENDS = "../visualizer/data/benchmark-trends.json";
 
 type LatestFiles = {
   summary: string | null;
@@ -42,10 +52,10 @@ async function findLatestFiles(): Promise<LatestFiles> {
             latestSummary = filePath;
             // find matching results file (same timestamp)
             const timestamp = file.replace("summary-", "").replace(".json", "");
-            const resultsFile = `results-${timestamp}.json`;
-            if (files.includes(resultsFile)) {
-              latestResults = join(versionDir, resultsFile);
-            }
+            const resultsFile = [`results-${timestamp}.ndjson`, `results-${timestamp}.json`].find((f) =>
+              files.includes(f)
+            );
+            latestResults = resultsFile ? join(versionDir, resultsFile) : null;
           }
         }
       }
@@ -71,23 +81,37 @@ async function main() {
   await writeFile(VISUALIZER_DATA, summaryContent);
   console.log(`copied to: ${VISUALIZER_DATA}`);
 
+  // parse and show quick stats
+  const data = JSON.parse(summaryContent);
+
   if (results) {
     console.log(`found results: ${results}`);
-    const resultsContent = await readFile(results, "utf-8");
-    await writeFile(VISUALIZER_DETAILS, resultsContent);
-    console.log(`copied to: ${VISUALIZER_DETAILS}`);
+    // a resumed log can hold a failed request and its retry; the later one wins
+    const all: OptimizationResult[] = results.endsWith(".ndjson")
+      ? await readResultsLog(results)
+      : JSON.parse(await readFile(results, "utf-8")).results;
+    const latest = [...new Map(all.map((r) => [resultKey(r), r])).values()];
+    const written = await writeDetailShards(latest, data.metadata, VISUALIZER_DETAILS, VISUALIZER_SHARDS);
+    console.log(`wrote: ${VISUALIZER_DETAILS} (${written.cells} cells), ${written.shards} shards in ${VISUALIZER_SHARDS}`);
+  }
+
+  // every stored run of the same suite, for the speedup-across-versions chart
+  if (data.metadata?.suiteId) {
+    const trends = trendSeries(await updateRunIndex(), data.metadata.suiteId);
+    await writeFile(VISUALIZER_TRENDS, JSON.stringify(trends, null, 2));
+    console.log(`trends: ${trends.versions.length} versions -> ${VISUALIZER_TRENDS}`);
   }
 
-  // parse and show quick stats
-  const data = JSON.parse(summaryContent);
   console.log("\nstats:");
   console.log(`  suite: ${data.metadata?.testSuite}`);
   console.log(`  version: ${data.metadata?.version}`);
   console.log(`  models: ${data.rankings?.length}`);
 
-  // handle both old format (successRate) and new format (avgSpeedup)
+  // handle the old format (successRate), avgSpeedup, and geomeanSpeedup rankings
   const topModel = data.rankings?.[0];
-  if (topModel?.avgSpeedup) {
+  if (topModel?.geomeanSpeedup) {
+    console.log(`  top model: ${topModel.model} (${topModel.geomeanSpeedup.toFixed(2)}x geomean speedup)`);
+  } else if (topModel?.avgSpeedup) {
     console.log(`  top model: ${topModel.model} (${topModel.avgSpeedup.toFixed(2)}x speedup)`);
   } else if (topModel?.successRate) {
     console.log(`  top model: ${topModel.model} (${topModel.successRate.toFixed(1)}%)`);
@@ -0,0 +1,292 @@
+// remote measurement workers
+// in distributed mode the coordinator only asks the models and dedupes their
+// answers; compile, verify and measure run on worker agents (worker.ts) on
+// quiet, identical machines. every test has a home worker so its baselines are
+// measured (and cached) once, and an idle worker steals queued candidates from
+// the tail of the busiest queue so long tests don't leave the others idle
+
+import { createHash } from "crypto";
+import { request as httpRequest } from "http";
+import { request as httpsRequest } from "https";
+import type { Hotspot } from "./perf-counters";
+import type { Calibration, HostFingerprint } from "./calibration";
+import type { PromptVariant, TokenUsage } from "./prompt-variant";
+import type { Candidate, OptimizationResult, OptimizationTest, TimingMode } from "./optimization-runner";
+import type { SamplingConfig } from "./sampling";
+import type { Toolchain } from "./toolchain";
+import { failCandidate } from "./optimization-runner";
+
+export type WorkerInfo = {
+  host: HostFingerprint;
+  fingerprint: string; // short hash of `host`, equal on identical machines
+  calibration?: Calibration;
+  slots: number; // candidates it measures at once, one per timing core
+};
+
+// what a worker needs to finish a candidate the coordinator generated
+export type MeasureRequest = {
+  job: {
+    model: string;
+    test: OptimizationTest;
+    sample?: number;
+    variant?: PromptVariant;
+    timingMode?: TimingMode;
+    sampling?: SamplingConfig;
+    toolchains?: Toolchain[]; // as configured on the coordinator's job, else the worker's own
+    sweep?: boolean;
+    replay?: string;
+    refineRounds: number;
+  };
+  round: number;
+  code?: string;
+  response?: string;
+  generation: {
+    tokensUsed: number;
+    usage?: TokenUsage;
+    costUsd?: number;
+    generationMs: number;
+    generationKey?: string;
+    generationCached?: boolean;
+  };
+};
+
+export type MeasureResponse = {
+  result: OptimizationResult;
+  hotspots?: Hotspot[];
+  stopRefining?: boolean;
+};
+
+export type WorkerConfig = {
+  queueDepth: number;
+  requestTimeoutMs: number; // per /measure call
+  keepAliveMs: number; // idle time before tcp keepalive probes start
+  heartbeatMs: number;
+  heartbeatTimeoutMs: number;
+  heartbeatMisses: number; // failed heartbeats in a row before the worker counts as dead
+};
+
+export type WorkerPool = {
+  workers: Array<{ url: string; info: WorkerInfo }>;
+  slots: number; // summed over workers
+  measure(c: Candidate): Promise<Candidate>;
+};
+
+export function fingerprintHash(host: HostFingerprint): string {
+  return createHash("sha1").update(JSON.stringify(host)).digest("hex").slice(0, 12);
+}
+
+export const WORKER_TOKEN_HEADER = "x-optibench-token";
+
+type CallOptions = { timeoutMs: number; keepAliveMs?: number; signal?: AbortSignal };
+
+// plain http(s) rather than fetch: a measurement can take many minutes and
+// fetch gives up on slow headers. timeouts and aborts reject without a status,
+// like a refused connection
+function call<T>(url: string, token: string, path: string, options: CallOptions, body?: unknown): Promise<T> {
+  const target = new URL(path, url);
+  const request = target.protocol === "https:" ? httpsRequest : httpRequest;
+  const payload = body === undefined ? undefined : JSON.stringify(body);
+  return new Promise((resolve, reject) => {
+    const req = request(
+      target,
+      {
+        method: payload ? "POST" : "GET",
+        signal: options.signal,
+        headers: {
+          [WORKER_TOKEN_HEADER]: token,
+          ...(payload ? { "content-type": "application/json", "content-length": Buffer.byteLength(payload) } : {}),
+        },
+      },
+      (res) => {
+        let data = "";
+        res.setEncoding("utf-8");
+        res.on("data", (chunk) => (data += chunk));
+        res.on("end", () => {
+          if (res.statusCode !== 200) {
+            return reject(Object.assign(new Error(`${target.host}: HTTP ${res.statusCode} ${data.slice(0, 200)}`), { status: res.statusCode }));
+          }
+          try {
+            resolve(JSON.parse(data) as T);
+          } catch (err) {
+            reject(err);
+          }
+        });
+      }
+    );
+    req.setTimeout(options.timeoutMs, () => req.destroy(new Error(`${target.host}: no answer in ${options.timeoutMs} ms`)));
+    if (options.keepAliveMs) req.setSocketKeepAlive(true, options.keepAliveMs);
+    req.on("error", reject);
+    req.end(payload);
+  });
+}
+
+export function measureRequest(c: Candidate, refineRounds: number): MeasureRequest {
+  const { job } = c;
+  return {
+    job: {
+      model: job.model.name,
+      test: job.test,
+      sample: job.sample,
+      variant: job.variant,
+      timingMode: job.timingMode,
+      sampling: job.sampling,
+      toolchains: job.toolchains,
+      sweep: job.sweep,
+      replay: job.replay,
+      refineRounds: job.refineRounds ?? refineRounds,
+    },
+    round: c.round,
+    code: c.code,
+    response: c.response,
+    generation: {
+      tokensUsed: c.tokensUsed,
+      usage: c.usage,
+      costUsd: c.costUsd,
+      generationMs: c.generationMs,
+      generationKey: c.generationKey,
+      generationCached: c.generationCached,
+    },
+  };
+}
+
+type Task = { c: Candidate; home: number; attempts: number; resolve: (c: Candidate) => void };
+
+type WorkerState = {
+  url: string;
+  info: WorkerInfo;
+  queue: Task[];
+  active: number;
+  alive: boolean;
+  misses: number; // failed heartbeats in a row
+  abort: AbortController; // cancels its in-flight measurements once it is given up on
+};
+
+// unreachable workers are left out; throws when none answers
+export async function connectWorkers(
+  urls: string[],
+  token: string,
+  refineRounds: number,
+  config: WorkerConfig
+): Promise<WorkerPool> {
+  const ping = { timeoutMs: config.heartbeatTimeoutMs };
+  const reached = await Promise.all(
+    urls.map((url) =>
+      call<WorkerInfo>(url, token, "/info", ping).then(
+        (info): WorkerState => ({ url, info, queue: [], active: 0, alive: true, misses: 0, abort: new AbortController() }),
+        () => null
+      )
+    )
+  );
+  const workers = reached.filter((w): w is WorkerState => w !== null);
+  if (workers.length === 0) throw new Error(`No worker answered (${urls.join(", ")})`);
+
+  // a test always lands on the same worker first, so its baselines come from
+  // that worker's cache
+  const homeOf = (testId: string) =>
+    createHash("sha1").update(testId).digest().readUInt32BE(0) % workers.length;
+
+  // own queue first, oldest task; otherwise the newest task of the longest
+  // queue, which its owner would reach last
+  const next = (w: WorkerState): Task | undefined => {
+    if (w.queue.length > 0) return w.queue.shift();
+    const victim = workers
+      .filter((o) => o !== w && o.queue.length > 0)
+      .sort((a, b) => b.queue.length - a.queue.length)[0];
+    return victim?.queue.pop();
+  };
+
+  const pump = () => {
+    for (const w of workers) {
+      while (w.alive && w.active < w.info.slots) {
+        const task = next(w);
+        if (!task) break;
+        run(w, task);
+      }
+    }
+  };
+
+  const run = async (w: WorkerState, task: Task) => {
+    w.active++;
+    const { c } = task;
+    try {
+      const response = await call<MeasureResponse>(
+        w.url,
+        token,
+        "/measure",
+        { timeoutMs: config.requestTimeoutMs, keepAliveMs: config.keepAliveMs, signal: w.abort.signal },
+        measureRequest(c, refineRounds)
+      );
+      c.result = response.result;
+      c.hotspots = response.hotspots;
+      c.stopRefining = response.stopRefining;
+      task.resolve(c);
+    } catch (err) {
+      // the worker answered but this candidate broke it; the worker stays
+      if ((err as { status?: number }).status) {
+        const message = `Worker ${w.url} failed: ${(err as Error).message}`;
+        task.resolve(failCandidate(c, { compileError: message, infraError: message }));
+        return;
+      }
+      // a dead worker's tasks move to the live ones; one retry per task
+      giveUp(w);
+      const live = workers.filter((o) => o.alive);
+      for (const t of w.queue.splice(0)) live[t.home % Math.max(1, live.length)]?.queue.push(t);
+      if (task.attempts === 0 && live.length > 0) {
+        task.attempts++;
+        live[0].queue.unshift(task);
+      } else {
+        const message = `Worker ${w.url} failed: ${(err as Error).message ?? err}`;
+        task.resolve(failCandidate(c, { compileError: message, infraError: message }));
+      }
+      if (live.length === 0) {
+        for (const t of workers.flatMap((o) => o.queue.splice(0))) {
+          t.resolve(failCandidate(t.c, { compileError: "No worker left", infraError: "No worker left" }));
+        }
+      }
+    } finally {
+      w.active--;
+      pump();
+    }
+  };
+
+  // marks the worker dead and aborts its in-flight calls; the first of them
+  // to reach run()'s catch moves the queue over
+  const giveUp = (w: WorkerState) => {
+    if (!w.alive) return;
+    w.alive = false;
+    w.abort.abort(new Error(`${w.url} stopped answering`));
+  };
+
+  // a worker that is measuring must still answer /info; the in-flight calls to
+  // one that doesn't are aborted into the dead-worker path above
+  const heartbeat = setInterval(() => {
+    for (const w of workers) {
+      if (!w.alive || w.active === 0) continue;
+      call<WorkerInfo>(w.url, token, "/info", ping).then(
+        () => (w.misses = 0),
+        () => {
+          if (++w.misses >= config.heartbeatMisses) giveUp(w);
+        }
+      );
+    }
+  }, config.heartbeatMs);
+  heartbeat.unref();
+
+  return {
+    workers: workers.map(({ url, info }) => ({ url, info })),
+    slots: workers.reduce((sum, w) => sum + w.info.slots, 0),
+    measure(c) {
+      return new Promise((resolve) => {
+        const home = homeOf(c.job.test.id);
+        const live = workers.filter((w) => w.alive);
+        const owner = workers[home].alive ? workers[home] : live[home % live.length];
+        if (!owner) {
+          resolve(failCandidate(c, { compileError: "No worker left", infraError: "No worker left" }));
+          return;
+        }
+        owner.queue.push({ c, home, attempts: 0, resolve });
+        pump();
+      });
+    },
+  };
+}
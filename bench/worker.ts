@@ -0,0 +1,120 @@
+#!/usr/bin/env bun
+// measurement worker agent for distributed runs
+//   OPTIBENCH_WORKER_TOKEN=<secret> bun run worker [--port 7070]
+// compiles, verifies and times candidates a coordinator generated (see
+// worker-pool.ts). it runs model-written code, so keep it on a private network
+// or behind an ssh tunnel (ssh -L 7070:localhost:7070 host)
+
+import { timingSafeEqual } from "crypto";
+import { createServer, type IncomingMessage, type ServerResponse } from "http";
+import {
+  STAGES,
+  createCandidate,
+  failCandidate,
+  resolveDuplicate,
+  settleCandidate,
+  type TestJob,
+} from "./optimization-runner";
+import { calibrate, hostFingerprint } from "./calibration";
+import { getTimedScheduler } from "./scheduler";
+import {
+  fingerprintHash,
+  WORKER_TOKEN_HEADER,
+  type MeasureRequest,
+  type MeasureResponse,
+  type WorkerInfo,
+} from "./worker-pool";
+import { CALIBRATION_CONFIG, SCHEDULER_CONFIG, WORKER_CONFIG, type RunnableModel } from "./constants";
+
+async function measure(req: MeasureRequest, info: WorkerInfo): Promise<MeasureResponse> {
+  const job: TestJob = {
+    // only the name is used past the generate stage
+    model: { name: req.job.model } as RunnableModel,
+    test: req.job.test,
+    systemPrompt: "",
+    sample: req.job.sample,
+    variant: req.job.variant,
+    timingMode: req.job.timingMode,
+    sampling: req.job.sampling,
+    toolchains: req.job.toolchains,
+    sweep: req.job.sweep,
+    replay: req.job.replay,
+    refineRounds: req.job.refineRounds,
+    silent: true,
+  };
+  let c = createCandidate(job);
+  Object.assign(c, { round: req.round, code: req.code, response: req.response, ...req.generation });
+
+  // extract (which dedupes identical code on this worker) onwards
+  for (const stage of STAGES.slice(1)) {
+    try {
+      c = await stage.run(c);
+    } catch (err) {
+      c = failCandidate(c, { compileError: `Pipeline error in ${stage.name}: ${err}` });
+    }
+    if (c.original && !c.result) c = await resolveDuplicate(c);
+    if (c.result) break;
+  }
+  settleCandidate(c);
+
+  const result = { ...c.result!, worker: { hostname: info.host.hostname, fingerprint: info.fingerprint } };
+  return { result, hotspots: c.hotspots, stopRefining: c.stopRefining };
+}
+
+function readBody(req: IncomingMessage): Promise<string> {
+  return new Promise((resolve, reject) => {
+    let body = "";
+    req.setEncoding("utf-8");
+    req.on("data", (chunk) => (body += chunk));
+    req.on("end", () => resolve(body));
+    req.on("error", reject);
+  });
+}
+
+function send(res: ServerResponse, status: number, body: unknown) {
+  res.writeHead(status, { "content-type": "application/json" });
+  res.end(JSON.stringify(body));
+}
+
+async function main() {
+  const token = process.env[WORKER_CONFIG.tokenEnv];
+  if (!token) throw new Error(`${WORKER_CONFIG.tokenEnv} must be set`);
+  const i = process.argv.indexOf("--port");
+  const port = i >= 0 ? Number(process.argv[i + 1]) : WORKER_CONFIG.port;
+
+  // calibrated once up front; measureStage picks up the same numbers
+  const host = hostFingerprint();
+  const info: WorkerInfo = {
+    host,
+    fingerprint: fingerprintHash(host),
+    calibration: await calibrate(CALIBRATION_CONFIG),
+    slots: Math.max(1, getTimedScheduler(SCHEDULER_CONFIG).timingCpus.length),
+  };
+
+  const server = createServer(async (req, res) => {
+    const given = Buffer.from(String(req.headers[WORKER_TOKEN_HEADER] ?? ""));
+    const expected = Buffer.from(token);
+    if (given.length !== expected.length || !timingSafeEqual(given, expected)) {
+      return send(res, 401, { error: "bad token" });
+    }
+    try {
+      if (req.method === "GET" && req.url === "/info") return send(res, 200, info);
+      if (req.method === "POST" && req.url === "/measure") {
+        return send(res, 200, await measure(JSON.parse(await readBody(req)) as MeasureRequest, info));
+      }
+      send(res, 404, { error: "not found" });
+    } catch (err) {
+      send(res, 500, { error: String(err) });
+    }
+  });
+  // measurements can run for many minutes
+  server.requestTimeout = 0;
+  server.listen(port, () => {
+    console.log(`worker ${info.fingerprint} (${host.cpuModel}, ${info.slots} slots) listening on :${port}`);
+  });
+}
+
+main().catch((e) => {
+  console.error(e);
+  process.exit(1);
+});
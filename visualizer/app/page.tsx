@@ -1,6 +1,6 @@
 "use client";
 
-import { useState, useMemo, type ComponentPropsWithoutRef } from "react";
+import { useState, useMemo, useEffect, type ComponentPropsWithoutRef } from "react";
 import {
   Trophy,
   DollarSign,
@@ -17,9 +17,12 @@ import {
   Zap,
   Cpu,
   Gauge,
+  Server,
+  Package,
 } from "lucide-react";
 import benchmarkData from "../data/benchmark-results.json";
 import detailsData from "../data/benchmark-details.json";
+import trendsData from "../data/benchmark-trends.json";
 
 import { Button } from "@/components/ui/button";
 import {
@@ -56,6 +59,8 @@ import {
   CartesianGrid,
   ScatterChart,
   Scatter,
+  LineChart,
+  Line,
   Cell,
   LabelList,
 } from "recharts";
@@ -64,6 +69,7 @@ import {
   ChartTooltip,
   ChartTooltipContent,
 } from "@/components/ui/chart";
+import { useVirtualRows } from "@/hooks/use-virtual-rows";
 import { useIsMobile } from "@/hooks/use-mobile";
 
 const OptiBenchLogo = ({ className }: { className?: string }) => (
@@ -91,8 +97,34 @@ interface ModelData {
   testsRun?: number;
   compiled?: number;
   avgSpeedup?: number;
+  geomeanSpeedup?: number; // failed tests count as 1x
   maxSpeedup?: number;
   avgTimeMs?: number;
+  avgMemoryRatio?: number;
+  avgRooflinePercent?: number; // over tests that declare their work
+  speedupPerDollar?: number;
+  speedupPerSecond?: number;
+}
+
+interface LeaderboardViews {
+  pareto?: { cost: string[]; latency: string[] };
+  variants?: Array<{
+    family: string;
+    models: Array<{ model: string; reasoning: boolean; geomeanSpeedup: number; averageCostPerTest?: number; avgTimeMs: number }>;
+    reasoningGain?: number;
+  }>;
+  promptVariants?: Array<{
+    model: string;
+    variant: string;
+    testsRun: number;
+    passRate: number;
+    geomeanSpeedup: number;
+    speedupVsFirst?: number;
+    avgTimeMs: number;
+    avgInputTokens: number;
+    avgOutputTokens: number;
+    avgReasoningTokens: number;
+  }>;
 }
 
 interface TestResult {
@@ -102,18 +134,253 @@ interface TestResult {
   compiled: boolean;
   correct: boolean;
   speedup: number;
+  speedupCI?: [number, number];
   baselineTimeMs: number;
   optimizedTimeMs: number;
+  baselineStats?: SampleStats;
+  optimizedStats?: SampleStats;
+  baselineCounters?: PerfCounters;
+  optimizedCounters?: PerfCounters;
+  baselineResources?: ResourceUsage;
+  optimizedResources?: ResourceUsage;
+  baselineBandwidthGBs?: number;
+  optimizedBandwidthGBs?: number;
+  baselineRoofline?: Roofline;
+  optimizedRoofline?: Roofline;
+  belowNoiseFloor?: boolean;
+  baselineFootprint?: Footprint;
+  optimizedFootprint?: Footprint;
+  footprintPenalty?: number;
+  footprintCap?: string;
+  scaling?: ScalingResult;
+  oracle?: { checks: number; sizes: number[]; seeds: number[]; mismatch?: string };
+  threadScaling?: ThreadScaling;
+  refinement?: Refinement;
+  codegen?: { baseline?: CodegenReport; optimized?: CodegenReport };
   duration: number;
   compileError?: string;
   optimizedCode?: string;
+  optimizedCodeGz?: string; // base64 gzip, in detail shards
+  sample?: number;
+}
+
+interface SampleStats {
+  n: number;
+  median: number;
+  mad: number;
+  ciLow: number;
+  ciHigh: number;
+}
+
+interface PerfCounters {
+  cycles?: number;
+  instructions?: number;
+  ipc?: number;
+  l1dMisses?: number;
+  llcMisses?: number;
+  dtlbMisses?: number;
+  branchMisses?: number;
+  vectorInstructions?: number;
+}
+
+interface Roofline {
+  gflops?: number;
+  gops?: number;
+  gbs?: number;
+  bound: "flops" | "ops" | "bytes";
+  percent: number;
+}
+
+interface Footprint {
+  compileMs?: number;
+  size?: { text: number; rodata: number; data: number; bss: number; file: number };
+  startupMs?: number;
+}
+
+interface ResourceUsage {
+  maxRssKb: number;
+  minorFaults: number;
+  majorFaults: number;
+  voluntaryCtxSwitches: number;
+  involuntaryCtxSwitches: number;
+}
+
+interface ThreadScaling {
+  singleThreadSpeedup: number;
+  points: Array<{ threads: number; timeMs: number; speedup: number; efficiency: number; correct: boolean }>;
+  maxThreads: number;
+  efficiencyAtMax?: number;
+}
+
+interface Refinement {
+  rounds: Array<{ round: number; compiled: boolean; correct: boolean; speedup: number; optimizedTimeMs: number; error?: string }>;
+  bestRound: number;
+}
+
+interface CodegenReport {
+  functions: Array<{ name: string; instructions: number; vectorInstructions: number; vectorWidthBits: number }>;
+  loops: Array<{ line: number; kind: "vectorized" | "unrolled" | "missed"; detail: string }>;
+  maxVectorWidthBits: number;
+  kernel?: string;
+  kernelInstructions?: number;
+  kernelAsm?: string;
+}
+
+interface ScalingResult {
+  param: string;
+  points: Array<{
+    value: number;
+    baselineTimeMs: number;
+    optimizedTimeMs: number;
+    speedup: number;
+    correct: boolean;
+    error?: string;
+  }>;
+  baselineExponent?: number;
+  optimizedExponent?: number;
+  constantTime?: boolean;
+}
+
+// one heatmap cell: every sample of a (model, test)
+interface DetailCell {
+  model: string;
+  testId: string;
+  testName: string;
+  samples: number;
+  compiled: number;
+  correct: number;
+  speedup: number; // median over correct samples
+  bestSpeedup: number;
+  representative: number; // sample opened first, closest to the median
+  shard?: string; // public/details/<shard>.json, fetched when the cell is opened
+  results?: TestResult[]; // inline, for details files written before sharding
 }
 
 interface DetailsData {
-  results: TestResult[];
+  cells?: DetailCell[];
+  results?: TestResult[];
   metadata?: any;
 }
 
+function median(values: number[]) {
+  if (values.length === 0) return 0;
+  const sorted = [...values].sort((a, b) => a - b);
+  const mid = Math.floor(sorted.length / 2);
+  return sorted.length % 2 === 0 ? (sorted[mid - 1] + sorted[mid]) / 2 : sorted[mid];
+}
+
+// sharded details carry their cells; older files inline every result
+function detailCells(details?: DetailsData): DetailCell[] {
+  if (details?.cells) return details.cells;
+  const groups = new Map<string, TestResult[]>();
+  for (const r of details?.results ?? []) {
+    const key = `${r.model}\t${r.testId}`;
+    (groups.get(key) ?? groups.set(key, []).get(key)!).push(r);
+  }
+  return [...groups.values()].map((results) => {
+    const speedups = results.filter((r) => r.correct).map((r) => r.speedup);
+    const mid = median(speedups);
+    const representative = results.reduce(
+      (best, r, i) =>
+        r.correct && (!results[best].correct || Math.abs(r.speedup - mid) < Math.abs(results[best].speedup - mid))
+          ? i
+          : best,
+      0
+    );
+    return {
+      model: results[0].model,
+      testId: results[0].testId,
+      testName: results[0].testName,
+      samples: results.length,
+      compiled: results.filter((r) => r.compiled).length,
+      correct: speedups.length,
+      speedup: mid,
+      bestSpeedup: Math.max(0, ...speedups),
+      representative,
+      results,
+    };
+  });
+}
+
+async function gunzipBase64(data: string): Promise<string> {
+  const bytes = Uint8Array.from(atob(data), (c) => c.charCodeAt(0));
+  const stream = new Blob([bytes]).stream().pipeThrough(new DecompressionStream("gzip"));
+  return new Response(stream).text();
+}
+
+// the samples of an opened cell, fetched from its shard, and the chosen one
+// with its source decompressed
+function useCellResults(cell: DetailCell | null) {
+  const [results, setResults] = useState<TestResult[] | null>(null);
+  const [index, setIndex] = useState(0);
+  const [error, setError] = useState<string | null>(null);
+  const [code, setCode] = useState<string | undefined>(undefined);
+
+  useEffect(() => {
+    setResults(null);
+    setError(null);
+    if (!cell) return;
+    setIndex(cell.representative);
+    if (cell.results) {
+      setResults(cell.results);
+      return;
+    }
+    let cancelled = false;
+    fetch(`/details/${cell.shard}.json`)
+      .then((res) => (res.ok ? res.json() : Promise.reject(new Error(`HTTP ${res.status}`))))
+      .then((shard: { results: TestResult[] }) => !cancelled && setResults(shard.results))
+      .catch((e: Error) => !cancelled && setError(e.message));
+    return () => {
+      cancelled = true;
+    };
+  }, [cell]);
+
+  const raw = results?.[index] ?? null;
+  useEffect(() => {
+    setCode(raw?.optimizedCode);
+    if (!raw?.optimizedCodeGz || raw.optimizedCode) return;
+    let cancelled = false;
+    gunzipBase64(raw.optimizedCodeGz).then((text) => !cancelled && setCode(text));
+    return () => {
+      cancelled = true;
+    };
+  }, [raw]);
+
+  const result = useMemo(() => (raw ? { ...raw, optimizedCode: code } : null), [raw, code]);
+  return { results, index, setIndex, result, error };
+}
+
+function SamplePicker({
+  results,
+  index,
+  onSelect,
+}: {
+  results: TestResult[] | null;
+  index: number;
+  onSelect: (i: number) => void;
+}) {
+  if (!results || results.length < 2) return null;
+  return (
+    <div className="flex flex-wrap gap-1.5 mb-6">
+      {results.map((r, i) => (
+        <button
+          key={i}
+          onClick={() => onSelect(i)}
+          className={`px-2 py-1 rounded-md text-xs font-mono border transition-colors ${
+            i === index
+              ? "border-cyan-500/50 bg-cyan-500/10 text-cyan-300"
+              : "border-neutral-800 text-neutral-400 hover:border-neutral-600"
+          }`}
+        >
+          #{r.sample ?? i} {r.compiled ? (r.correct ? `${r.speedup.toFixed(2)}x` : "✗") : "err"}
+        </button>
+      ))}
+    </div>
+  );
+}
+
+const HEATMAP_ROW_HEIGHT = 49;
+
 function withAlpha(color: string, alpha: number) {
   if (color.startsWith("hsl("))
     return color.replace("hsl(", "hsla(").replace(")", `, ${alpha})`);
@@ -215,6 +482,512 @@ function truncateLabel(input: unknown, max = 14) {
   return label.slice(0, Math.max(1, max - 1)) + "…";
 }
 
+function formatCI(ci?: [number, number]) {
+  if (!ci || ci[1] <= 0) return null;
+  return `95% CI ${ci[0].toFixed(2)}–${ci[1].toFixed(2)}x`;
+}
+
+function formatCount(n?: number) {
+  if (n === undefined) return "-";
+  if (n >= 1e9) return `${(n / 1e9).toFixed(2)}G`;
+  if (n >= 1e6) return `${(n / 1e6).toFixed(2)}M`;
+  if (n >= 1e3) return `${(n / 1e3).toFixed(1)}K`;
+  return n.toFixed(0);
+}
+
+const COUNTER_ROWS: Array<{ key: keyof PerfCounters; label: string }> = [
+  { key: "cycles", label: "Cycles" },
+  { key: "instructions", label: "Instructions" },
+  { key: "ipc", label: "IPC" },
+  { key: "l1dMisses", label: "L1d misses" },
+  { key: "llcMisses", label: "LLC misses" },
+  { key: "dtlbMisses", label: "dTLB misses" },
+  { key: "branchMisses", label: "Branch misses" },
+  { key: "vectorInstructions", label: "Vector FP ops" },
+];
+
+function formatKb(kb?: number) {
+  if (kb === undefined) return "-";
+  if (kb >= 1024 * 1024) return `${(kb / 1024 / 1024).toFixed(2)} GB`;
+  if (kb >= 1024) return `${(kb / 1024).toFixed(1)} MB`;
+  return `${kb} KB`;
+}
+
+const RESOURCE_ROWS: Array<{ key: keyof ResourceUsage; label: string }> = [
+  { key: "maxRssKb", label: "Peak RSS" },
+  { key: "minorFaults", label: "Minor faults" },
+  { key: "majorFaults", label: "Major faults" },
+  { key: "voluntaryCtxSwitches", label: "Voluntary ctx switches" },
+  { key: "involuntaryCtxSwitches", label: "Involuntary ctx switches" },
+];
+
+function ResourcesTable({ baseline, optimized }: { baseline?: ResourceUsage; optimized?: ResourceUsage }) {
+  if (!baseline && !optimized) return null;
+  const format = (key: keyof ResourceUsage, r?: ResourceUsage) =>
+    key === "maxRssKb" ? formatKb(r?.maxRssKb) : formatCount(r?.[key]);
+  return (
+    <div className="space-y-3 mb-6">
+      <h4 className="text-sm font-medium text-neutral-300 flex items-center gap-2">
+        <Cpu className="w-4 h-4 text-cyan-400" /> Resources
+      </h4>
+      <table className="w-full text-xs font-mono">
+        <thead>
+          <tr className="text-neutral-500 uppercase tracking-wider">
+            <th className="text-left py-1.5 font-medium">Metric</th>
+            <th className="text-right py-1.5 font-medium">Baseline</th>
+            <th className="text-right py-1.5 font-medium">Optimized</th>
+          </tr>
+        </thead>
+        <tbody>
+          {RESOURCE_ROWS.map((row) => (
+            <tr key={row.key} className="border-t border-neutral-800/50 text-neutral-200">
+              <td className="py-1.5 text-neutral-400">{row.label}</td>
+              <td className="py-1.5 text-right">{format(row.key, baseline)}</td>
+              <td className="py-1.5 text-right">{format(row.key, optimized)}</td>
+            </tr>
+          ))}
+        </tbody>
+      </table>
+    </div>
+  );
+}
+
+function formatBytes(n?: number) {
+  return n === undefined ? "-" : formatKb(Math.round(n / 1024)).replace(/^0 KB$/, `${n} B`);
+}
+
+const FOOTPRINT_ROWS: Array<{ label: string; value: (f?: Footprint) => string }> = [
+  { label: "Compile time", value: (f) => (f?.compileMs !== undefined ? `${(f.compileMs / 1000).toFixed(2)}s` : "-") },
+  { label: ".text", value: (f) => formatBytes(f?.size?.text) },
+  { label: ".rodata", value: (f) => formatBytes(f?.size?.rodata) },
+  { label: ".data", value: (f) => formatBytes(f?.size?.data) },
+  { label: "Binary", value: (f) => formatBytes(f?.size?.file) },
+  { label: "Time to main", value: (f) => (f?.startupMs !== undefined ? `${f.startupMs.toFixed(2)} ms` : "-") },
+];
+
+function FootprintTable({ result }: { result?: TestResult | null }) {
+  if (!result?.baselineFootprint && !result?.optimizedFootprint) return null;
+  return (
+    <div className="space-y-3 mb-6">
+      <h4 className="text-sm font-medium text-neutral-300 flex items-center gap-2">
+        <Package className="w-4 h-4 text-cyan-400" /> Build Footprint
+        {result.footprintCap ? (
+          <Badge variant="outline" className="border-red-900/50 text-red-400">
+            {result.footprintCap}
+          </Badge>
+        ) : result.footprintPenalty !== undefined ? (
+          <span className="text-xs text-neutral-500">ranked at {result.footprintPenalty.toFixed(2)}x its speedup</span>
+        ) : null}
+      </h4>
+      <table className="w-full text-xs font-mono">
+        <thead>
+          <tr className="text-neutral-500 uppercase tracking-wider">
+            <th className="text-left py-1.5 font-medium">Metric</th>
+            <th className="text-right py-1.5 font-medium">Baseline</th>
+            <th className="text-right py-1.5 font-medium">Optimized</th>
+          </tr>
+        </thead>
+        <tbody>
+          {FOOTPRINT_ROWS.map((row) => (
+            <tr key={row.label} className="border-t border-neutral-800/50 text-neutral-200">
+              <td className="py-1.5 text-neutral-400">{row.label}</td>
+              <td className="py-1.5 text-right">{row.value(result.baselineFootprint)}</td>
+              <td className="py-1.5 text-right">{row.value(result.optimizedFootprint)}</td>
+            </tr>
+          ))}
+        </tbody>
+      </table>
+    </div>
+  );
+}
+
+function CountersTable({ baseline, optimized }: { baseline?: PerfCounters; optimized?: PerfCounters }) {
+  if (!baseline && !optimized) return null;
+  return (
+    <div className="space-y-3 mb-6">
+      <h4 className="text-sm font-medium text-neutral-300 flex items-center gap-2">
+        <Gauge className="w-4 h-4 text-cyan-400" /> Hardware Counters
+      </h4>
+      <table className="w-full text-xs font-mono">
+        <thead>
+          <tr className="text-neutral-500 uppercase tracking-wider">
+            <th className="text-left py-1.5 font-medium">Event</th>
+            <th className="text-right py-1.5 font-medium">Baseline</th>
+            <th className="text-right py-1.5 font-medium">Optimized</th>
+          </tr>
+        </thead>
+        <tbody>
+          {COUNTER_ROWS.filter((row) => baseline?.[row.key] !== undefined || optimized?.[row.key] !== undefined).map((row) => (
+            <tr key={row.key} className="border-t border-neutral-800/50 text-neutral-200">
+              <td className="py-1.5 text-neutral-400">{row.label}</td>
+              <td className="py-1.5 text-right">
+                {row.key === "ipc" ? baseline?.ipc?.toFixed(2) ?? "-" : formatCount(baseline?.[row.key] as number | undefined)}
+              </td>
+              <td className="py-1.5 text-right">
+                {row.key === "ipc" ? optimized?.ipc?.toFixed(2) ?? "-" : formatCount(optimized?.[row.key] as number | undefined)}
+              </td>
+            </tr>
+          ))}
+        </tbody>
+      </table>
+    </div>
+  );
+}
+
+function formatExponent(k?: number) {
+  return k === undefined ? "-" : `n^${k.toFixed(2)}`;
+}
+
+// time vs size on log-log axes, so the slope is the scaling exponent
+function ScalingChart({ scaling }: { scaling?: ScalingResult }) {
+  if (!scaling || scaling.points.length === 0) return null;
+  const data = scaling.points.map((p) => ({
+    value: p.value,
+    baseline: p.baselineTimeMs > 0 ? p.baselineTimeMs : null,
+    optimized: p.correct && p.optimizedTimeMs > 0 ? p.optimizedTimeMs : null,
+  }));
+  return (
+    <div className="space-y-3 mb-6">
+      <h4 className="text-sm font-medium text-neutral-300 flex items-center gap-2">
+        <TrendingUp className="w-4 h-4 text-cyan-400" /> Scaling with {scaling.param}
+        <span className="text-neutral-500 font-normal font-mono text-xs">
+          baseline {formatExponent(scaling.baselineExponent)} · optimized {formatExponent(scaling.optimizedExponent)}
+        </span>
+      </h4>
+      <ChartContainer
+        config={{
+          baseline: { label: "Baseline", color: "hsl(0, 0%, 60%)" },
+          optimized: { label: "Optimized", color: "hsl(187, 85%, 53%)" },
+        }}
+        className="h-56 w-full"
+      >
+        <LineChart data={data} margin={{ top: 8, right: 16, left: 8, bottom: 8 }}>
+          <CartesianGrid strokeDasharray="3 3" stroke="#303341" />
+          <XAxis
+            dataKey="value"
+            type="number"
+            scale="log"
+            domain={["auto", "auto"]}
+            stroke="#9ca3af"
+            tickFormatter={(v) => formatCount(v)}
+          />
+          <YAxis
+            type="number"
+            scale="log"
+            domain={["auto", "auto"]}
+            stroke="#9ca3af"
+            unit="ms"
+            tickFormatter={(v) => Number(v).toPrecision(2)}
+          />
+          <ChartTooltip content={<ChartTooltipContent />} />
+          <Line dataKey="baseline" stroke="var(--color-baseline)" dot connectNulls isAnimationActive={false} />
+          <Line dataKey="optimized" stroke="var(--color-optimized)" dot connectNulls isAnimationActive={false} />
+        </LineChart>
+      </ChartContainer>
+      {scaling.constantTime ? (
+        <p className="text-xs text-amber-400">
+          Optimized time stays flat while the baseline grows — the answer may be precomputed
+        </p>
+      ) : null}
+      {scaling.points.some((p) => !p.correct) ? (
+        <p className="text-xs text-amber-400">
+          Wrong or missing output at {scaling.param} ={" "}
+          {scaling.points.filter((p) => !p.correct).map((p) => p.value).join(", ")}
+        </p>
+      ) : null}
+    </div>
+  );
+}
+
+function ThreadScalingTable({ scaling }: { scaling?: ThreadScaling }) {
+  if (!scaling || scaling.points.length === 0) return null;
+  return (
+    <div className="space-y-3 mb-6">
+      <h4 className="text-sm font-medium text-neutral-300 flex items-center gap-2">
+        <Cpu className="w-4 h-4 text-cyan-400" /> Thread Scaling
+        <span className="text-neutral-500 font-normal font-mono text-xs">
+          1 thread {scaling.singleThreadSpeedup.toFixed(2)}x
+          {scaling.efficiencyAtMax !== undefined
+            ? ` · ${(scaling.efficiencyAtMax * 100).toFixed(0)}% efficient at ${scaling.maxThreads}`
+            : ""}
+        </span>
+      </h4>
+      <table className="w-full text-xs font-mono">
+        <thead>
+          <tr className="text-neutral-500 uppercase tracking-wider">
+            <th className="text-left py-1.5 font-medium">Threads</th>
+            <th className="text-right py-1.5 font-medium">Time</th>
+            <th className="text-right py-1.5 font-medium">Speedup</th>
+            <th className="text-right py-1.5 font-medium">Efficiency</th>
+          </tr>
+        </thead>
+        <tbody>
+          {scaling.points.map((p) => (
+            <tr
+              key={p.threads}
+              className={`border-t border-neutral-800/50 ${p.correct ? "text-neutral-200" : "text-amber-400"}`}
+            >
+              <td className="py-1.5">{p.threads}</td>
+              <td className="py-1.5 text-right">{p.timeMs.toFixed(1)}ms</td>
+              <td className="py-1.5 text-right">{p.speedup.toFixed(2)}x</td>
+              <td className="py-1.5 text-right">{(p.efficiency * 100).toFixed(0)}%</td>
+            </tr>
+          ))}
+        </tbody>
+      </table>
+    </div>
+  );
+}
+
+function RefinementTable({ refinement }: { refinement?: Refinement }) {
+  if (!refinement || refinement.rounds.length < 2) return null;
+  return (
+    <div className="space-y-3 mb-6">
+      <h4 className="text-sm font-medium text-neutral-300 flex items-center gap-2">
+        <TrendingUp className="w-4 h-4 text-cyan-400" /> Refinement
+        <span className="text-neutral-500 font-normal font-mono text-xs">
+          best of {refinement.rounds.length} rounds: round {refinement.bestRound}
+        </span>
+      </h4>
+      <table className="w-full text-xs font-mono">
+        <thead>
+          <tr className="text-neutral-500 uppercase tracking-wider">
+            <th className="text-left py-1.5 font-medium">Round</th>
+            <th className="text-left py-1.5 font-medium">Outcome</th>
+            <th className="text-right py-1.5 font-medium">Time</th>
+            <th className="text-right py-1.5 font-medium">Speedup</th>
+          </tr>
+        </thead>
+        <tbody>
+          {refinement.rounds.map((r) => (
+            <tr
+              key={r.round}
+              className={`border-t border-neutral-800/50 ${r.correct ? "text-neutral-200" : "text-amber-400"} ${r.round === refinement.bestRound ? "font-semibold" : ""}`}
+            >
+              <td className="py-1.5">{r.round}</td>
+              <td className="py-1.5 truncate max-w-xs" title={r.error}>
+                {!r.compiled ? "build failed" : r.correct ? "correct" : "incorrect"}
+              </td>
+              <td className="py-1.5 text-right">{r.optimizedTimeMs > 0 ? `${r.optimizedTimeMs.toFixed(1)}ms` : "-"}</td>
+              <td className="py-1.5 text-right">{r.correct ? `${r.speedup.toFixed(2)}x` : "-"}</td>
+            </tr>
+          ))}
+        </tbody>
+      </table>
+    </div>
+  );
+}
+
+const loopColor = { vectorized: "text-emerald-400", unrolled: "text-cyan-400", missed: "text-amber-400" };
+
+function CodegenPanel({ codegen }: { codegen?: { baseline?: CodegenReport; optimized?: CodegenReport } }) {
+  const { baseline, optimized } = codegen ?? {};
+  if (!baseline && !optimized) return null;
+  const width = (bits?: number) => (bits === undefined ? "-" : bits > 0 ? `${bits}-bit` : "scalar");
+  const count = (r: CodegenReport | undefined, kind: string) => r?.loops.filter((l) => l.kind === kind).length ?? "-";
+  const rows: Array<[string, string | number, string | number]> = [
+    ["Vector width", width(baseline?.maxVectorWidthBits), width(optimized?.maxVectorWidthBits)],
+    ["Loops vectorized", count(baseline, "vectorized"), count(optimized, "vectorized")],
+    ["Loops unrolled", count(baseline, "unrolled"), count(optimized, "unrolled")],
+    ["Loops missed", count(baseline, "missed"), count(optimized, "missed")],
+    [
+      `Instructions (${optimized?.kernel ?? baseline?.kernel ?? "kernel"})`,
+      baseline?.kernelInstructions ?? "-",
+      optimized?.kernelInstructions ?? "-",
+    ],
+  ];
+  return (
+    <div className="space-y-3 mt-6">
+      <h4 className="text-sm font-medium text-neutral-300 flex items-center gap-2">
+        <Cpu className="w-4 h-4 text-cyan-400" /> Code Generation
+      </h4>
+      <table className="w-full text-xs font-mono">
+        <thead>
+          <tr className="text-neutral-500 uppercase tracking-wider">
+            <th className="text-left py-1.5 font-medium"></th>
+            <th className="text-right py-1.5 font-medium">Baseline</th>
+            <th className="text-right py-1.5 font-medium">Optimized</th>
+          </tr>
+        </thead>
+        <tbody>
+          {rows.map(([label, b, o]) => (
+            <tr key={label} className="border-t border-neutral-800/50 text-neutral-200">
+              <td className="py-1.5 text-neutral-400">{label}</td>
+              <td className="py-1.5 text-right">{b}</td>
+              <td className="py-1.5 text-right">{o}</td>
+            </tr>
+          ))}
+        </tbody>
+      </table>
+      {optimized && optimized.loops.length > 0 ? (
+        <ul className="text-xs font-mono space-y-0.5">
+          {optimized.loops.map((l, i) => (
+            <li key={i} className={loopColor[l.kind]}>
+              <span className="text-neutral-500">line {l.line}:</span> {l.kind} {l.detail}
+            </li>
+          ))}
+        </ul>
+      ) : null}
+      <div className="grid grid-cols-2 gap-3">
+        {[baseline, optimized].map((r, i) => (
+          <pre
+            key={i}
+            className="p-3 rounded-xl bg-neutral-950/50 border border-neutral-800/50 text-neutral-300 text-[11px] overflow-auto max-h-80 font-mono leading-snug"
+          >
+            {r?.kernelAsm ?? "no assembly"}
+          </pre>
+        ))}
+      </div>
+    </div>
+  );
+}
+
+interface Trends {
+  suiteId?: string;
+  versions: Array<{ version: string; host?: string; timestamp: string }>;
+  series: Array<{
+    model: string;
+    testId: string;
+    points: Array<{ version: string; host?: string; samples: number; passRate: number; medianSpeedup: number }>;
+  }>;
+}
+
+// per model, the geometric mean over tests of the median speedup at each
+// stored version (and host), from `bun run compare <suite> --trend`
+function TrendChart({
+  trends,
+  models,
+  colorOf,
+}: {
+  trends: Trends;
+  models: string[];
+  colorOf: (model: string) => string;
+}) {
+  const shown = models.filter((m) => trends.series.some((s) => s.model === m));
+  if (trends.versions.length < 2 || shown.length === 0) return null;
+  const hosts = new Set(trends.versions.map((v) => v.host ?? ""));
+  const label = (v: { version: string; host?: string }) =>
+    hosts.size > 1 && v.host ? `${v.version} @ ${v.host.split(" @ ").pop()}` : v.version;
+
+  const data = trends.versions.map((v) => {
+    const row: Record<string, string | number | null> = { label: label(v) };
+    shown.forEach((model, i) => {
+      const speedups = trends.series
+        .filter((s) => s.model === model)
+        .flatMap((s) => s.points.filter((p) => p.version === v.version && p.host === v.host && p.medianSpeedup > 0))
+        .map((p) => p.medianSpeedup);
+      row[`m${i}`] = speedups.length
+        ? Math.exp(speedups.reduce((sum, x) => sum + Math.log(x), 0) / speedups.length)
+        : null;
+    });
+    return row;
+  });
+
+  return (
+    <div className="space-y-3 mt-8">
+      <h4 className="text-sm font-medium text-neutral-300 flex items-center gap-2">
+        <TrendingUp className="w-4 h-4 text-cyan-400" /> Speedup Across Versions
+        <span className="text-neutral-500 font-normal text-xs">geomean of per-test median speedups</span>
+      </h4>
+      <ChartContainer
+        config={Object.fromEntries(shown.map((m, i) => [`m${i}`, { label: m, color: colorOf(m) }]))}
+        className="h-64 w-full"
+      >
+        <LineChart data={data} margin={{ top: 8, right: 16, left: 8, bottom: 8 }}>
+          <CartesianGrid strokeDasharray="3 3" stroke="#303341" />
+          <XAxis dataKey="label" stroke="#9ca3af" />
+          <YAxis stroke="#9ca3af" unit="x" domain={["auto", "auto"]} tickFormatter={(v) => Number(v).toFixed(1)} />
+          <ChartTooltip content={<ChartTooltipContent />} />
+          {shown.map((m, i) => (
+            <Line key={m} dataKey={`m${i}`} stroke={`var(--color-m${i})`} dot connectNulls isAnimationActive={false} />
+          ))}
+        </LineChart>
+      </ChartContainer>
+    </div>
+  );
+}
+
+function VariantsTable({ variants }: { variants?: LeaderboardViews["variants"] }) {
+  if (!variants || variants.length === 0) return null;
+  return (
+    <div className="space-y-3 mt-8">
+      <h4 className="text-sm font-medium text-neutral-300 flex items-center gap-2">
+        <Sparkles className="w-4 h-4 text-amber-400" /> Reasoning Variants
+      </h4>
+      <table className="w-full text-xs font-mono">
+        <thead>
+          <tr className="text-neutral-500 uppercase tracking-wider">
+            <th className="text-left py-1.5 font-medium">Model</th>
+            <th className="text-left py-1.5 font-medium">Reasoning</th>
+            <th className="text-right py-1.5 font-medium">Geomean</th>
+            <th className="text-right py-1.5 font-medium">Cost / test</th>
+            <th className="text-right py-1.5 font-medium">Latency</th>
+          </tr>
+        </thead>
+        {variants.map((v) => (
+          <tbody key={v.family}>
+            <tr className="border-t border-neutral-700/70 text-neutral-500">
+              <td className="pt-3 pb-1" colSpan={5}>
+                {v.family}
+                {v.reasoningGain !== undefined ? ` · reasoning ${v.reasoningGain.toFixed(2)}x` : ""}
+              </td>
+            </tr>
+            {v.models.map((m) => (
+              <tr key={m.model} className="border-t border-neutral-800/50 text-neutral-200">
+                <td className="py-1.5">{m.model}</td>
+                <td className="py-1.5">{m.reasoning ? "yes" : "no"}</td>
+                <td className="py-1.5 text-right">{m.geomeanSpeedup.toFixed(2)}x</td>
+                <td className="py-1.5 text-right">{m.averageCostPerTest !== undefined ? currency(m.averageCostPerTest) : "-"}</td>
+                <td className="py-1.5 text-right">{(m.avgTimeMs / 1000).toFixed(1)}s</td>
+              </tr>
+            ))}
+          </tbody>
+        ))}
+      </table>
+    </div>
+  );
+}
+
+function PromptVariantsTable({ variants }: { variants?: LeaderboardViews["promptVariants"] }) {
+  if (!variants || variants.length === 0) return null;
+  const tokens = (n: number) => (n > 0 ? Math.round(n).toLocaleString() : "-");
+  return (
+    <div className="space-y-3 mt-8">
+      <h4 className="text-sm font-medium text-neutral-300 flex items-center gap-2">
+        <Sparkles className="w-4 h-4 text-cyan-400" /> Prompt Variants
+      </h4>
+      <table className="w-full text-xs font-mono">
+        <thead>
+          <tr className="text-neutral-500 uppercase tracking-wider">
+            <th className="text-left py-1.5 font-medium">Model</th>
+            <th className="text-left py-1.5 font-medium">Variant</th>
+            <th className="text-right py-1.5 font-medium">Geomean</th>
+            <th className="text-right py-1.5 font-medium">Vs first</th>
+            <th className="text-right py-1.5 font-medium">Pass</th>
+            <th className="text-right py-1.5 font-medium">In / out / reasoning tokens</th>
+            <th className="text-right py-1.5 font-medium">Latency</th>
+          </tr>
+        </thead>
+        <tbody>
+          {variants.map((v) => (
+            <tr key={`${v.model}:${v.variant}`} className="border-t border-neutral-800/50 text-neutral-200">
+              <td className="py-1.5">{v.model}</td>
+              <td className="py-1.5">{v.variant}</td>
+              <td className="py-1.5 text-right">{v.geomeanSpeedup.toFixed(2)}x</td>
+              <td className="py-1.5 text-right">{v.speedupVsFirst !== undefined ? `${v.speedupVsFirst.toFixed(2)}x` : "-"}</td>
+              <td className="py-1.5 text-right">{(v.passRate * 100).toFixed(0)}%</td>
+              <td className="py-1.5 text-right">
+                {tokens(v.avgInputTokens)} / {tokens(v.avgOutputTokens)} / {tokens(v.avgReasoningTokens)}
+              </td>
+              <td className="py-1.5 text-right">{(v.avgTimeMs / 1000).toFixed(1)}s</td>
+            </tr>
+          ))}
+        </tbody>
+      </table>
+    </div>
+  );
+}
+
 function getSpeedupColor(speedup: number, compiled: boolean, correct: boolean) {
   if (!compiled) return "bg-red-900/50 text-red-300";
   if (!correct) return "bg-orange-900/50 text-orange-300";
@@ -236,35 +1009,35 @@ function PerTestBreakdown({
   selectedModels: string[];
   getModelColor: (model: string) => string;
 }) {
-  const [selectedResult, setSelectedResult] = useState<TestResult | null>(null);
-  const results = details?.results ?? [];
+  const [selectedCell, setSelectedCell] = useState<DetailCell | null>(null);
+  const { results: sampleResults, index, setIndex, result: selectedResult, error } = useCellResults(selectedCell);
+  const cells = useMemo(() => detailCells(details), [details]);
 
   // get unique tests and models
-  const testIds = [...new Set(results.map((r) => r.testId))];
-  const testNames = Object.fromEntries(
-    results.map((r) => [r.testId, r.testName])
-  );
+  const testIds = [...new Set(cells.map((c) => c.testId))];
+  const testNames = Object.fromEntries(cells.map((c) => [c.testId, c.testName]));
   const modelNames = rankings
     .map((r) => r.model)
     .filter((m) => selectedModels.includes(m));
+  const rows = useVirtualRows(modelNames.length, HEATMAP_ROW_HEIGHT);
 
-  // build lookup map: model -> testId -> result
-  const resultMap = new Map<string, Map<string, TestResult>>();
-  for (const r of results) {
-    if (!resultMap.has(r.model)) {
-      resultMap.set(r.model, new Map());
+  // build lookup map: model -> testId -> cell
+  const cellMap = new Map<string, Map<string, DetailCell>>();
+  for (const c of cells) {
+    if (!cellMap.has(c.model)) {
+      cellMap.set(c.model, new Map());
     }
-    resultMap.get(r.model)!.set(r.testId, r);
+    cellMap.get(c.model)!.set(c.testId, c);
   }
 
-  // find best speedup per test (for highlighting)
+  // find best median speedup per test (for highlighting)
   const bestPerTest = new Map<string, number>();
   for (const testId of testIds) {
     let best = 0;
     for (const model of modelNames) {
-      const r = resultMap.get(model)?.get(testId);
-      if (r && r.correct && r.speedup > best) {
-        best = r.speedup;
+      const c = cellMap.get(model)?.get(testId);
+      if (c && c.correct > 0 && c.speedup > best) {
+        best = c.speedup;
       }
     }
     bestPerTest.set(testId, best);
@@ -282,7 +1055,7 @@ function PerTestBreakdown({
 
   return (
     <>
-      <Dialog open={!!selectedResult} onOpenChange={(open) => !open && setSelectedResult(null)}>
+      <Dialog open={!!selectedCell} onOpenChange={(open) => !open && setSelectedCell(null)}>
         <DialogContent className="max-w-4xl max-h-[85vh] overflow-hidden bg-neutral-900/95 backdrop-blur-xl border-neutral-700/50 rounded-2xl shadow-2xl shadow-black/50">
           <DialogHeader>
             <DialogTitle className="flex items-center gap-3 text-white">
@@ -290,14 +1063,16 @@ function PerTestBreakdown({
                 <Code className="h-4 w-4 text-cyan-400" />
               </div>
               <div>
-                <span className="text-neutral-400 text-sm font-normal">{selectedResult?.model}</span>
+                <span className="text-neutral-400 text-sm font-normal">{selectedCell?.model}</span>
                 <span className="mx-2 text-neutral-600">→</span>
-                {selectedResult?.testName}
+                {selectedCell?.testName}
               </div>
             </DialogTitle>
             <DialogDescription className="text-neutral-500 flex items-center gap-3 mt-2">
-              {selectedResult?.compiled ? (
-                selectedResult?.correct ? (
+              {!selectedResult ? (
+                <span>{error ? `Failed to load details: ${error}` : "Loading…"}</span>
+              ) : selectedResult.compiled ? (
+                selectedResult.correct ? (
                   <>
                     <Badge className="bg-emerald-500/10 text-emerald-400 border border-emerald-500/20">
                       <Zap className="w-3 h-3 mr-1" />
@@ -306,6 +1081,30 @@ function PerTestBreakdown({
                     <span className="text-neutral-600">
                       {selectedResult.baselineTimeMs.toFixed(1)}ms → {selectedResult.optimizedTimeMs.toFixed(1)}ms
                     </span>
+                    {formatCI(selectedResult.speedupCI) ? (
+                      <span className="text-neutral-500">
+                        {formatCI(selectedResult.speedupCI)}
+                        {selectedResult.baselineStats && selectedResult.optimizedStats
+                          ? ` · n=${selectedResult.baselineStats.n}/${selectedResult.optimizedStats.n}`
+                          : ""}
+                      </span>
+                    ) : null}
+                    {selectedResult.belowNoiseFloor ? (
+                      <Badge variant="outline" className="border-neutral-700/50 text-neutral-400">
+                        within noise floor
+                      </Badge>
+                    ) : null}
+                    {selectedResult.baselineBandwidthGBs && selectedResult.optimizedBandwidthGBs ? (
+                      <span className="text-neutral-500">
+                        {selectedResult.baselineBandwidthGBs.toFixed(1)} → {selectedResult.optimizedBandwidthGBs.toFixed(1)} GB/s
+                      </span>
+                    ) : null}
+                    {selectedResult.baselineRoofline && selectedResult.optimizedRoofline ? (
+                      <span className="text-neutral-500" title="least time the declared work needs at the host's peaks / measured time">
+                        {(selectedResult.baselineRoofline.percent * 100).toFixed(0)}% →{" "}
+                        {(selectedResult.optimizedRoofline.percent * 100).toFixed(0)}% of roofline ({selectedResult.optimizedRoofline.bound}-bound)
+                      </span>
+                    ) : null}
                   </>
                 ) : (
                   <Badge className="bg-amber-500/10 text-amber-400 border border-amber-500/20">
@@ -320,6 +1119,33 @@ function PerTestBreakdown({
             </DialogDescription>
           </DialogHeader>
           <ScrollArea className="h-[60vh] mt-4">
+            <SamplePicker results={sampleResults} index={index} onSelect={setIndex} />
+            <CountersTable
+              baseline={selectedResult?.baselineCounters}
+              optimized={selectedResult?.optimizedCounters}
+            />
+            <ResourcesTable
+              baseline={selectedResult?.baselineResources}
+              optimized={selectedResult?.optimizedResources}
+            />
+            <FootprintTable result={selectedResult} />
+            <ScalingChart scaling={selectedResult?.scaling} />
+            <ThreadScalingTable scaling={selectedResult?.threadScaling} />
+            <RefinementTable refinement={selectedResult?.refinement} />
+            {selectedResult?.oracle?.mismatch ? (
+              <div className="space-y-3 mb-6">
+                <h4 className="text-sm font-medium text-amber-400 flex items-center gap-2">
+                  <Target className="w-4 h-4" /> Differential Check Failed
+                </h4>
+                <pre className="p-4 rounded-xl bg-amber-950/20 border border-amber-900/30 text-amber-200 text-xs overflow-x-auto whitespace-pre-wrap font-mono">
+                  {selectedResult.oracle.mismatch}
+                </pre>
+              </div>
+            ) : selectedResult?.oracle ? (
+              <p className="text-xs text-neutral-500 mb-6">
+                Matched the baseline on {selectedResult.oracle.checks} differential runs
+              </p>
+            ) : null}
             {selectedResult?.compileError ? (
               <div className="space-y-3">
                 <h4 className="text-sm font-medium text-red-400 flex items-center gap-2">
@@ -342,6 +1168,7 @@ function PerTestBreakdown({
             ) : (
               <p className="text-neutral-500">No code available</p>
             )}
+            <CodegenPanel codegen={selectedResult?.codegen} />
           </ScrollArea>
         </DialogContent>
       </Dialog>
@@ -359,10 +1186,10 @@ function PerTestBreakdown({
           </CardDescription>
         </CardHeader>
         <CardContent className="pt-4">
-          <ScrollArea className="w-full">
+          <div ref={rows.ref} onScroll={rows.onScroll} className="w-full max-h-[70vh] overflow-auto">
             <div className="min-w-[600px]">
               <table className="w-full text-sm">
-                <thead>
+                <thead className="sticky top-0 z-20 bg-neutral-900/95">
                   <tr>
                     <th className="sticky left-0 z-10 bg-neutral-900/90 backdrop-blur-sm px-4 py-3 text-left font-medium text-neutral-400 border-b border-neutral-800/50 uppercase text-xs tracking-wider">
                       Model
@@ -377,24 +1204,34 @@ function PerTestBreakdown({
                     </th>
                   ))}
                   <th className="px-4 py-3 text-right font-semibold text-emerald-400 border-b border-neutral-800/50 uppercase text-xs tracking-wider">
-                    Avg
+                    Geomean
                   </th>
                 </tr>
               </thead>
               <tbody>
-                {modelNames.map((model, idx) => {
-                  const modelResults = resultMap.get(model);
-                  const correctResults = testIds
-                    .map((t) => modelResults?.get(t))
-                    .filter((r) => r?.correct);
+                {rows.padTop > 0 ? <tr style={{ height: rows.padTop }} /> : null}
+                {modelNames.slice(rows.start, rows.end).map((model, i) => {
+                  const idx = rows.start + i;
+                  const modelCells = cellMap.get(model);
+                  // geometric mean like the rankings: failed cells count as 1x,
+                  // so one outlier test can't carry the row
+                  const ranCells = testIds
+                    .map((t) => modelCells?.get(t))
+                    .filter((c): c is DetailCell => !!c);
                   const avgSpeedup =
-                    correctResults.length > 0
-                      ? correctResults.reduce((s, r) => s + (r?.speedup ?? 0), 0) /
-                        correctResults.length
+                    ranCells.length > 0
+                      ? Math.exp(
+                          ranCells.reduce((s, c) => s + (c.correct > 0 && c.speedup > 0 ? Math.log(c.speedup) : 0), 0) /
+                            ranCells.length
+                        )
                       : 0;
 
                   return (
-                    <tr key={model} className="group hover:bg-neutral-800/30 transition-colors">
+                    <tr
+                      key={model}
+                      className="group hover:bg-neutral-800/30 transition-colors"
+                      style={{ height: HEATMAP_ROW_HEIGHT }}
+                    >
                       <td className="sticky left-0 z-10 bg-neutral-900/90 backdrop-blur-sm px-4 py-3 border-b border-neutral-800/30">
                         <div className="flex items-center gap-3">
                           <span className="text-neutral-600 text-xs font-mono w-4">{idx + 1}</span>
@@ -408,13 +1245,14 @@ function PerTestBreakdown({
                         </div>
                       </td>
                       {testIds.map((testId) => {
-                        const r = modelResults?.get(testId);
+                        const c = modelCells?.get(testId);
                         const isBest =
-                          r?.correct &&
-                          r.speedup > 0 &&
-                          r.speedup === bestPerTest.get(testId);
+                          c &&
+                          c.correct > 0 &&
+                          c.speedup > 0 &&
+                          c.speedup === bestPerTest.get(testId);
 
-                        if (!r) {
+                        if (!c) {
                           return (
                             <td
                               key={testId}
@@ -426,10 +1264,11 @@ function PerTestBreakdown({
                         }
 
                         const colorClass = getSpeedupColor(
-                          r.speedup,
-                          r.compiled,
-                          r.correct
+                          c.speedup,
+                          c.compiled > 0,
+                          c.correct > 0
                         );
+                        const samples = c.samples > 1 ? ` · ${c.correct}/${c.samples} correct` : "";
 
                         return (
                           <td
@@ -438,17 +1277,17 @@ function PerTestBreakdown({
                               isBest ? "ring-2 ring-emerald-400/50 ring-inset shadow-lg shadow-emerald-500/20" : ""
                             }`}
                             title={
-                              r.compiled
-                                ? r.correct
-                                  ? `${r.speedup.toFixed(2)}x speedup`
-                                  : "Wrong output"
+                              c.compiled > 0
+                                ? c.correct > 0
+                                  ? `${c.speedup.toFixed(2)}x ${c.samples > 1 ? "median " : ""}speedup${samples}`
+                                  : `Wrong output${samples}`
                                 : "Compile error"
                             }
-                            onClick={() => setSelectedResult(r)}
+                            onClick={() => setSelectedCell(c)}
                           >
-                            {r.compiled
-                              ? r.correct
-                                ? `${r.speedup.toFixed(1)}x`
+                            {c.compiled > 0
+                              ? c.correct > 0
+                                ? `${c.speedup.toFixed(1)}x`
                                 : "✗"
                               : "err"}
                           </td>
@@ -464,10 +1303,11 @@ function PerTestBreakdown({
                     </tr>
                   );
                 })}
+                {rows.padBottom > 0 ? <tr style={{ height: rows.padBottom }} /> : null}
               </tbody>
             </table>
           </div>
-        </ScrollArea>
+        </div>
       </CardContent>
     </Card>
     </>
@@ -475,10 +1315,14 @@ function PerTestBreakdown({
 }
 
 export default function BenchmarkVisualizer() {
-  const { rankings, metadata } = benchmarkData as {
+  const { rankings, metadata, pareto, variants, promptVariants } = benchmarkData as LeaderboardViews & {
     rankings: ModelData[];
     metadata: any;
   };
+  // newer summaries rank by geometric mean, older ones only have the average
+  const speedupOf = (m: ModelData) => m.geomeanSpeedup ?? m.avgSpeedup ?? 0;
+  const hasGeomean = rankings[0]?.geomeanSpeedup !== undefined;
+  const [paretoAxis, setParetoAxis] = useState<"cost" | "latency">("cost");
 
   const [selectedModels, setSelectedModels] = useState<string[]>(
     rankings.map((m) => m.model)
@@ -501,7 +1345,7 @@ export default function BenchmarkVisualizer() {
     .map((m) => ({
       model: m.model,
       value: isOptimFormat
-        ? Number((m.avgSpeedup ?? 0).toFixed(2))
+        ? Number(speedupOf(m).toFixed(2))
         : Number((m.successRate ?? 0).toFixed(1)),
       compiled: m.compiled ?? m.correct ?? 0,
       total: m.testsRun ?? m.totalTests ?? 0,
@@ -534,36 +1378,40 @@ export default function BenchmarkVisualizer() {
   const performanceData = filteredRankings.map((m) => ({
     model: m.model.replace(/-/g, " "),
     originalModel: m.model,
-    successRate: isOptimFormat ? (m.avgSpeedup ?? 0) : (m.successRate ?? 0),
+    successRate: isOptimFormat ? speedupOf(m) : (m.successRate ?? 0),
     totalCost: m.totalCost ?? 0,
+    costPerTest: m.averageCostPerTest ?? m.totalCost ?? 0,
     duration: (m.averageDuration ?? m.avgTimeMs ?? 0) / 1000,
+    speedupPerDollar: m.speedupPerDollar,
+    speedupPerSecond: m.speedupPerSecond,
+    pareto: (paretoAxis === "cost" ? pareto?.cost : pareto?.latency)?.includes(m.model) ?? false,
   }));
 
   // compute highlights from details
-  const details = (detailsData as DetailsData)?.results ?? [];
+  const details = useMemo(() => detailCells(detailsData as DetailsData), []);
   const highlights = useMemo(() => {
     if (!isOptimFormat || details.length === 0) return null;
 
     // find best single speedup
     let bestSingle = { model: "", test: "", speedup: 0 };
-    for (const r of details) {
-      if (r.correct && r.speedup > bestSingle.speedup) {
-        bestSingle = { model: r.model, test: r.testName, speedup: r.speedup };
+    for (const c of details) {
+      if (c.correct > 0 && c.bestSpeedup > bestSingle.speedup) {
+        bestSingle = { model: c.model, test: c.testName, speedup: c.bestSpeedup };
       }
     }
 
     // find best average model
     const topModel = rankings[0];
 
-    // find hardest test (lowest average speedup)
+    // find hardest test (lowest average of the per-model medians)
     const testSpeedups = new Map<string, { total: number; count: number; name: string }>();
-    for (const r of details) {
-      if (!testSpeedups.has(r.testId)) {
-        testSpeedups.set(r.testId, { total: 0, count: 0, name: r.testName });
+    for (const c of details) {
+      if (!testSpeedups.has(c.testId)) {
+        testSpeedups.set(c.testId, { total: 0, count: 0, name: c.testName });
       }
-      if (r.correct) {
-        const t = testSpeedups.get(r.testId)!;
-        t.total += r.speedup;
+      if (c.correct > 0) {
+        const t = testSpeedups.get(c.testId)!;
+        t.total += c.speedup;
         t.count++;
       }
     }
@@ -581,9 +1429,9 @@ export default function BenchmarkVisualizer() {
 
     // count compile failures per model
     const compileFailures = new Map<string, number>();
-    for (const r of details) {
-      if (!r.compiled) {
-        compileFailures.set(r.model, (compileFailures.get(r.model) ?? 0) + 1);
+    for (const c of details) {
+      if (c.compiled < c.samples) {
+        compileFailures.set(c.model, (compileFailures.get(c.model) ?? 0) + c.samples - c.compiled);
       }
     }
     const mostReliable = [...compileFailures.entries()]
@@ -592,7 +1440,7 @@ export default function BenchmarkVisualizer() {
     return {
       bestSingle,
       topModel: topModel?.model,
-      topModelSpeedup: topModel?.avgSpeedup ?? 0,
+      topModelSpeedup: topModel ? speedupOf(topModel) : 0,
       hardestTest,
       easiestTest,
       mostReliable: mostReliable?.[0] ?? rankings[0]?.model,
@@ -667,6 +1515,24 @@ export default function BenchmarkVisualizer() {
                 {new Date(metadata.timestamp).toLocaleDateString()}
               </Badge>
             ) : null}
+            {metadata?.host ? (
+              <Badge
+                variant="outline"
+                className="border-neutral-700/50 text-neutral-400 bg-neutral-900/50"
+                title={[
+                  `${metadata.host.hostname} · ${metadata.host.logicalCpus} cpus · linux ${metadata.host.kernel}`,
+                  ...Object.values(metadata.host.compilers ?? {}),
+                  metadata.calibration
+                    ? `noise floor ${(metadata.calibration.noiseFloor.harness * 100).toFixed(1)}% harness / ${(metadata.calibration.noiseFloor.process * 100).toFixed(1)}% process`
+                    : null,
+                ]
+                  .filter(Boolean)
+                  .join("\n")}
+              >
+                <Server className="mr-1.5 h-3 w-3" />
+                {metadata.host.cpuModel}
+              </Badge>
+            ) : null}
           </div>
         </div>
       </header>
@@ -821,7 +1687,7 @@ export default function BenchmarkVisualizer() {
                       </div>
                       <Badge className="ml-auto bg-neutral-800 text-neutral-200">
                         {isOptimFormat
-                          ? `${(m.avgSpeedup ?? 0).toFixed(2)}x`
+                          ? `${speedupOf(m).toFixed(2)}x`
                           : `${(m.successRate ?? 0).toFixed(1)}%`}
                       </Badge>
                     </DropdownMenuItem>
@@ -838,10 +1704,11 @@ export default function BenchmarkVisualizer() {
                   <div className="flex items-center justify-center w-8 h-8 rounded-lg bg-gradient-to-br from-emerald-500/20 to-teal-500/20">
                     <Zap className="h-4 w-4 text-emerald-400" />
                   </div>
-                  Average Speedup by Model
+                  {hasGeomean ? "Geometric-Mean Speedup by Model" : "Average Speedup by Model"}
                 </CardTitle>
                 <CardDescription className="text-neutral-500">
                   How much faster the optimized code runs compared to baseline
+                  {hasGeomean ? "; failed tests count as 1x" : ""}
                 </CardDescription>
               </CardHeader>
               <CardContent>
@@ -1242,10 +2109,28 @@ export default function BenchmarkVisualizer() {
                   <div className="flex items-center justify-center w-8 h-8 rounded-lg bg-gradient-to-br from-amber-500/20 to-orange-500/20">
                     <TrendingUp className="h-4 w-4 text-amber-400" />
                   </div>
-                  Speedup vs Cost Analysis
+                  {paretoAxis === "cost" ? "Speedup vs Cost Analysis" : "Speedup vs Latency Analysis"}
+                  {pareto ? (
+                    <div className="ml-auto flex gap-1">
+                      {(["cost", "latency"] as const).map((axis) => (
+                        <Button
+                          key={axis}
+                          size="sm"
+                          variant="outline"
+                          onClick={() => setParetoAxis(axis)}
+                          className={`h-7 rounded-lg border-neutral-700 text-xs ${paretoAxis === axis ? "bg-amber-600/30 text-white" : "bg-neutral-800 text-neutral-400"}`}
+                        >
+                          {axis}
+                        </Button>
+                      ))}
+                    </div>
+                  ) : null}
                 </CardTitle>
                 <CardDescription className="text-neutral-500">
-                  Top-left is ideal: higher speedup with lower API costs
+                  {paretoAxis === "cost"
+                    ? "Top-left is ideal: higher speedup with lower API costs"
+                    : "Top-left is ideal: higher speedup with faster generation"}
+                  {pareto ? "; outlined points are Pareto-optimal" : ""}
                 </CardDescription>
               </CardHeader>
               <CardContent>
@@ -1270,10 +2155,10 @@ export default function BenchmarkVisualizer() {
                     <CartesianGrid strokeDasharray="3 3" stroke="#303341" />
                     <XAxis
                       type="number"
-                      dataKey="totalCost"
-                      name="Total Cost"
+                      dataKey={paretoAxis === "cost" ? (pareto ? "costPerTest" : "totalCost") : "duration"}
+                      name={paretoAxis === "cost" ? "Cost" : "Latency"}
                       label={{
-                        value: "Total Cost ($)",
+                        value: paretoAxis === "cost" ? (pareto ? "Cost per Test ($)" : "Total Cost ($)") : "Generation Time (s)",
                         position: "insideBottom",
                         offset: -20,
                         fill: "#9ca3af",
@@ -1315,6 +2200,17 @@ export default function BenchmarkVisualizer() {
                               <p className="text-sm text-neutral-300">
                                 Time: {d.duration.toFixed(2)}s
                               </p>
+                              {d.speedupPerDollar !== undefined ? (
+                                <p className="text-sm text-neutral-300">
+                                  Speedup per dollar: {d.speedupPerDollar.toFixed(1)}
+                                </p>
+                              ) : null}
+                              {d.speedupPerSecond !== undefined ? (
+                                <p className="text-sm text-neutral-300">
+                                  Speedup per second: {d.speedupPerSecond.toFixed(3)}
+                                </p>
+                              ) : null}
+                              {d.pareto ? <p className="text-sm text-amber-400">Pareto-optimal</p> : null}
                             </div>
                           );
                         }
@@ -1326,6 +2222,8 @@ export default function BenchmarkVisualizer() {
                         <Cell
                           key={entry.originalModel}
                           fill={getModelColor(entry.originalModel)}
+                          stroke={entry.pareto ? "#fbbf24" : undefined}
+                          strokeWidth={entry.pareto ? 3 : 0}
                         />
                       ))}
                       {!isMobile ? (
@@ -1356,6 +2254,15 @@ export default function BenchmarkVisualizer() {
                     </Scatter>
                   </ScatterChart>
                 </ChartContainer>
+                <VariantsTable variants={variants} />
+                <PromptVariantsTable variants={promptVariants} />
+                {(trendsData as Trends).suiteId === metadata?.suiteId ? (
+                  <TrendChart
+                    trends={trendsData as Trends}
+                    models={filteredRankings.map((m) => m.model)}
+                    colorOf={getModelColor}
+                  />
+                ) : null}
               </CardContent>
             </Card>
           </TabsContent>
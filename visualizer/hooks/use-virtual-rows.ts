@@ -0,0 +1,34 @@
+import * as React from "react"
+
+// windowed rendering for fixed-height table rows: only the rows inside the
+// scroll container (plus overscan) are mounted, the rest become two spacers
+export function useVirtualRows(count: number, rowHeight: number, overscan = 6) {
+  const ref = React.useRef<HTMLDivElement>(null)
+  const [scrollTop, setScrollTop] = React.useState(0)
+  const [viewport, setViewport] = React.useState(800)
+
+  React.useEffect(() => {
+    const el = ref.current
+    if (!el) return
+    const observer = new ResizeObserver(() => setViewport(el.clientHeight))
+    observer.observe(el)
+    setViewport(el.clientHeight)
+    return () => observer.disconnect()
+  }, [])
+
+  const onScroll = React.useCallback((e: React.UIEvent<HTMLDivElement>) => {
+    setScrollTop(e.currentTarget.scrollTop)
+  }, [])
+
+  const start = Math.max(0, Math.floor(scrollTop / rowHeight) - overscan)
+  const end = Math.min(count, Math.ceil((scrollTop + viewport) / rowHeight) + overscan)
+
+  return {
+    ref,
+    onScroll,
+    start,
+    end,
+    padTop: start * rowHeight,
+    padBottom: (count - end) * rowHeight,
+  }
+}